@@ -17,6 +17,7 @@ try:
     from .project_factory import Project
     from .project import all_completed
     from .project import recent_project
+    from .project import lock_statistics
 except ImportError:
     import warnings
 
@@ -7,7 +7,6 @@ import os
 import shutil
 from pathlib import Path
 from subprocess import call
-import time
 from lxml import etree
 
 
@@ -39,6 +38,15 @@ def recent_project(suffix, rank=1):
     """
     return ProjectWrapper.recent(suffix, rank)
 
+
+def lock_statistics():
+    """
+    Contention statistics for every lock file used in this process, for diagnosing stalls
+
+    :return: A dictionary keyed by lock file path, whose values are dictionaries of statistic names and values
+    """
+    return ProjectWrapper.lock_statistics()
+
 class Project(Node):
     """
     Project is a node with parsed output as the only child.
@@ -231,10 +239,7 @@ class Project(Node):
         Wait unconditionally for status() to return neither 'waiting' nor 'running'
         :param max_epoch: maximum time to wait between checking status (seconds)
         """
-        epoch = 0.001
-        while self.status in ["running", "waiting"]:
-            time.sleep(epoch)
-            epoch = min(epoch * 2, max_epoch)
+        self._project_wrapper.wait(max(1, int(max_epoch * 1e6)))
 
     def kill(self):
         """Kill the job started by ``run()``"""
@@ -359,6 +364,12 @@ class Project(Node):
         """
         return self._project_wrapper.property_get(properties)
 
+    def property_get_prefix(self, prefix):
+        """
+        Return a dictionary of property, value pairs for all properties whose names begin with prefix
+        """
+        return self._project_wrapper.property_get_prefix(prefix)
+
     def property_names(self):
         """
         Return names of all assigned properties
@@ -420,6 +431,15 @@ class Project(Node):
         """
         return self._project_wrapper.backend_parameter_delete(backend, param)
 
+    def backend_parameter_values(self, backend):
+        """
+        Gets all backend parameters that have been set in the property file.
+
+        :param backend: name of the backend
+        :return: A dictionary where the keys are the parameter names, and the values the values set
+        """
+        return self._project_wrapper.backend_parameter_values(backend)
+
     def backend_parameter_get(self, backend, param):
         """
         Gets backend parameter from property file.
@@ -36,8 +36,8 @@ cdef extern from "sjef/sjef.h" namespace "sjef":
         bool run_needed(int) except +
         void run_directory_new() except +
         void kill() except + nogil
-        void wait() except +
-        void wait(unsigned int) except +
+        void wait() except + nogil
+        void wait(unsigned int) except + nogil
         status status() except +
         string name() except +
         string filename_string() except +
@@ -45,6 +45,7 @@ cdef extern from "sjef/sjef.h" namespace "sjef":
         void property_delete(vector[string] &) except +
         map[string, string] property_get(vector[string] &) except +
         vector[string] property_names() except +
+        map[string, string] property_get_prefix(string &) except +
         size_t project_hash() except +
         size_t input_hash() except +
         int recent_find(string &) except +
@@ -57,6 +58,7 @@ cdef extern from "sjef/sjef.h" namespace "sjef":
         void backend_parameter_set(string &, string &, string &) except +
         void backend_parameter_delete(string &, string &) except +
         string backend_parameter_get(string &, string &) except +
+        map[string, string] backend_parameter_values(string &) except +
         string backend_parameter_documentation(string &, string &) except +
         string backend_parameter_default(string &, string &) except +
         vector[string] xpath_search(string &, string &, int) except +
@@ -64,3 +66,7 @@ cdef extern from "sjef/sjef.h" namespace "sjef":
 #    cdef string recent(string&, int) except +
 
 # cdef extern from "molpro-project.h" namespace "molpro::project":
+
+cdef extern from "sjef/sjef-c.h":
+    char** sjef_lock_paths()
+    char** sjef_lock_statistics(const char*)
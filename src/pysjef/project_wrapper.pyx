@@ -5,9 +5,10 @@ from libcpp.string cimport string
 from libcpp.vector cimport vector
 from libcpp.map cimport map
 from libcpp.memory cimport unique_ptr, make_unique
+from libc.stdlib cimport free
 
 from libcpp cimport nullptr, bool
-from .project_wrapper cimport status, Project
+from .project_wrapper cimport status, Project, sjef_lock_paths, sjef_lock_statistics
 
 import os
 from pathlib import Path
@@ -243,11 +244,14 @@ cdef class ProjectWrapper:
     def wait(self, max_microseconds = None):
         """Wait for completion of the job started by ``run``"""
         cdef unsigned int max_time
+        cdef Project* proj = self.c_project.get()
         if max_microseconds:
             max_time = max_microseconds
-            deref(self.c_project).wait(max_time)
+            with nogil:
+                deref(proj).wait(max_time)
         else:
-            deref(self.c_project).wait()
+            with nogil:
+                deref(proj).wait()
 
     def file_contents(self, str extension, str name=None):
         """Return file contents"""
@@ -341,6 +345,17 @@ cdef class ProjectWrapper:
                 res[prop] = v1
         return res
 
+    def property_get_prefix(self, prefix):
+        """
+        Return all properties whose names begin with a prefix
+        """
+        cdef string cprefix = str(self.__property_name_prefix + prefix).encode('utf-8')
+        cdef map[string, string] cresult = deref(self.c_project).property_get_prefix(cprefix)
+        result = dict()
+        for (key, value) in cresult:
+            result[key.decode('utf-8')[len(self.__property_name_prefix):]] = value.decode('utf-8')
+        return result
+
     def property_names(self):
         """
         Return names of all assigned properties
@@ -432,6 +447,20 @@ cdef class ProjectWrapper:
         cdef string cvalue = deref(self.c_project).backend_parameter_get(cbackend, cparam)
         return cvalue.decode('utf-8')
 
+    def backend_parameter_values(self, backend):
+        """
+        Gets all backend parameters that have been set in the property file.
+
+        :param backend: name of the backend
+        :return: A dictionary where the keys are the parameter names, and the values the values set
+        """
+        cdef string cbackend = str(backend).encode('utf-8')
+        cdef map[string, string] cresult = deref(self.c_project).backend_parameter_values(cbackend)
+        result = dict()
+        for (key, value) in cresult:
+            result[key.decode('utf-8')] = value.decode('utf-8')
+        return result
+
     def backend_parameter_documentation(self, backend, param):
         """
         Returns documentation for backend parameter
@@ -478,3 +507,42 @@ cdef class ProjectWrapper:
         cdef string csuffix = str(suffix).encode('utf-8')
         cdef string cvalue = Project.recent(csuffix, number)
         return cvalue.decode('utf-8')
+
+    @staticmethod
+    def lock_statistics():
+        """
+        Contention statistics for every lock file used in this process
+
+        :return: A dictionary keyed by lock file path, whose values are dictionaries of statistic names and values
+        """
+        cdef char** cpaths = sjef_lock_paths()
+        cdef char** cvalues
+        cdef size_t i
+        cdef size_t j
+        result = dict()
+        if cpaths == NULL:
+            return result
+        i = 0
+        while cpaths[i] != NULL:
+            path = cpaths[i].decode('utf-8')
+            cvalues = sjef_lock_statistics(cpaths[i])
+            values = dict()
+            if cvalues != NULL:
+                j = 0
+                while cvalues[j] != NULL:
+                    values[cvalues[j].decode('utf-8')] = cvalues[j + 1].decode('utf-8')
+                    free(cvalues[j])
+                    free(cvalues[j + 1])
+                    j += 2
+                free(cvalues)
+            for key in ('hold_histogram', 'shared_hold_histogram'):
+                if key in values:
+                    values[key] = [int(n) for n in values[key].split()]
+            for key in ('acquisitions', 'shared_acquisitions', 'total_wait_ns', 'max_wait_ns', 'shared_holders'):
+                if key in values:
+                    values[key] = int(values[key])
+            result[path] = values
+            free(cpaths[i])
+            i += 1
+        free(cpaths)
+        return result
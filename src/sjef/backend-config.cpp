@@ -11,6 +11,7 @@
 #include <yaml.h>
 
 #include "util/Locker.h"
+#include "util/util.h"
 
 #include <regex>
 namespace fs = std::filesystem;
@@ -31,13 +32,9 @@ namespace sjef {
         return s_file_suffix;
     }
 
-    inline fs::path sjef_config_directory() {
-        return fs::path(expand_path(getenv("SJEF_CONFIG") == nullptr ? "~/.sjef" : getenv("SJEF_CONFIG")));
-    }
-
     fs::path backend_config_file_path(const std::string &project_suffix, std::string config_file_suffix) {
         if (config_file_suffix == "") config_file_suffix = backend_config_file_suffix();
-        return sjef_config_directory() / project_suffix / ("backends." + config_file_suffix);
+        return util::sjef_config_directory() / project_suffix / ("backends." + config_file_suffix);
     }
 
     void save_backend_config(const std::map<std::string, Backend> &backends, const std::string &project_suffix) {
@@ -107,6 +104,14 @@ namespace sjef {
                             "\" ";
                 if (backend.kill_command != "")
                     stream << "\n           kill_command=\"" + backend.kill_command + "\" ";
+                if (backend.status_batch_command != "")
+                    stream << "\n           status_batch_command=\"" + backend.status_batch_command + "\" ";
+                if (backend.poll_interval_min != "")
+                    stream << "\n           poll_interval_min=\"" + backend.poll_interval_min + "\" ";
+                if (backend.poll_interval_max != "")
+                    stream << "\n           poll_interval_max=\"" + backend.poll_interval_max + "\" ";
+                if (backend.run_array_command != "")
+                    stream << "\n           run_array_command=\"" + backend.run_array_command + "\" ";
                 stream << "\n  />" << std::endl;
             }
             stream << "</backends>" << std::endl;
@@ -126,6 +131,14 @@ namespace sjef {
                 if (backend.status_waiting != "")
                     stream << yaml1("status_waiting" , backend.status_waiting) << std::endl;
                 if (backend.kill_command != "") stream << yaml1("kill_command" , backend.kill_command) << std::endl;
+                if (backend.status_batch_command != "")
+                    stream << yaml1("status_batch_command" , backend.status_batch_command) << std::endl;
+                if (backend.poll_interval_min != "")
+                    stream << yaml1("poll_interval_min" , backend.poll_interval_min) << std::endl;
+                if (backend.poll_interval_max != "")
+                    stream << yaml1("poll_interval_max" , backend.poll_interval_max) << std::endl;
+                if (backend.run_array_command != "")
+                    stream << yaml1("run_array_command" , backend.run_array_command, true) << std::endl;
                 stream << std::endl;
             }
         } else throw std::invalid_argument("Invalid suffix");
@@ -179,6 +192,14 @@ namespace sjef {
                         result[kName].status_waiting = kVal;
                     if (const auto kVal = getattribute(be, "kill_command"); kVal != "")
                         result[kName].kill_command = kVal;
+                    if (const auto kVal = getattribute(be, "status_batch_command"); kVal != "")
+                        result[kName].status_batch_command = kVal;
+                    if (const auto kVal = getattribute(be, "poll_interval_min"); kVal != "")
+                        result[kName].poll_interval_min = kVal;
+                    if (const auto kVal = getattribute(be, "poll_interval_max"); kVal != "")
+                        result[kName].poll_interval_max = kVal;
+                    if (const auto kVal = getattribute(be, "run_array_command"); kVal != "")
+                        result[kName].run_array_command = kVal;
                 }
             } catch (...) {
             }
@@ -240,6 +261,10 @@ namespace sjef {
                                     if (key == "status_running") result[backend_key].status_running = value;
                                     if (key == "status_waiting") result[backend_key].status_waiting = value;
                                     if (key == "kill_command") result[backend_key].kill_command = value;
+                                    if (key == "status_batch_command") result[backend_key].status_batch_command = value;
+                                    if (key == "poll_interval_min") result[backend_key].poll_interval_min = value;
+                                    if (key == "poll_interval_max") result[backend_key].poll_interval_max = value;
+                                    if (key == "run_array_command") result[backend_key].run_array_command = value;
                                 }
                             }
                         default:
@@ -17,7 +17,11 @@ const std::vector<std::string> sjef::Backend::s_keys = std::vector<std::string>{
     "status_command",
     "status_running",
     "status_waiting",
-    "kill_command"
+    "kill_command",
+    "status_batch_command",
+    "poll_interval_min",
+    "poll_interval_max",
+    "run_array_command"
     // clang-format on
 };
 
@@ -31,7 +35,11 @@ std::string sjef::Backend::str() const {
             << " status_command=\"" << status_command << "\""
             << " status_running=\"" << status_running << "\""
             << " status_waiting=\"" << status_waiting << "\""
-            << " kill_command=\"" << kill_command << "\"";
+            << " kill_command=\"" << kill_command << "\""
+            << " status_batch_command=\"" << status_batch_command << "\""
+            << " poll_interval_min=\"" << poll_interval_min << "\""
+            << " poll_interval_max=\"" << poll_interval_max << "\""
+            << " run_array_command=\"" << run_array_command << "\"";
     return ss.str();
 }
 
@@ -16,6 +16,18 @@ public:
   std::string status_running;
   std::string status_waiting;
   std::string kill_command;
+  //! If not empty, a command that queries the status of many jobs at once, with {jobs} replaced by their
+  //! comma-separated job numbers; jobs polled by one process on the same host then share a single query per cycle
+  std::string status_batch_command;
+  //! The shortest time in seconds between polls of a job's status, used while it is changing. If empty, the polling
+  //! interval is limited only by the time taken by a poll.
+  std::string poll_interval_min;
+  //! The longest time in seconds between polls of a job's status, reached by backing off while nothing changes. If
+  //! empty, 5 seconds.
+  std::string poll_interval_max;
+  //! If not empty, a command that submits several jobs at once, such as a scheduler's array submission, when given
+  //! their input files; its output must match run_jobnumber once for each job, in the same order
+  std::string run_array_command;
   static std::string default_name;
   static std::string dummy_name;
   Backend(std::string name, std::string host, std::string cache, std::string run_command, std::string run_jobnumber,
@@ -1,11 +1,13 @@
 #include "sjef-c.h"
 #include "sjef-backend.h"
 #include "sjef.h"
+#include "util/Locker.h"
 #include <chrono>
 #include <functional>
 #include <iostream>
 #include <map>
 #include <pugixml.hpp>
+#include <sstream>
 #include <string>
 #include <string.h>
 namespace fs = std::filesystem;
@@ -235,6 +237,25 @@ char** sjef_project_properties_get(const char* project, const char** key) {
   }
   return NULL;
 }
+char** sjef_project_property_get_prefix(const char* project, const char* prefix) {
+  char** result = NULL;
+  try {
+    if (projects.count(project) == 0)
+      sjef_project_open(project);
+    auto keyval = projects.at(project)->property_get_prefix(prefix);
+    result = (char**)malloc(sizeof(char*) * (2 * keyval.size() + 1));
+    size_t i = 0;
+    for (const auto& kv : keyval) {
+      result[i++] = strdup(kv.first.c_str());
+      result[i++] = strdup(kv.second.c_str());
+    }
+    result[i] = NULL;
+  } catch (std::exception& e) {
+    error(e);
+  } catch (...) {
+  }
+  return result;
+}
 void sjef_project_property_delete(const char* project, const char* key) {
   try {
     if (projects.count(project) == 0)
@@ -414,6 +435,26 @@ char** sjef_project_backend_parameters(const char* project, const char* backend,
   return result;
 }
 
+char** sjef_project_backend_parameter_values(const char* project, const char* backend) {
+  char** result = NULL;
+  try {
+    if (projects.count(project) == 0)
+      sjef_project_open(project);
+    auto values = projects.at(project)->backend_parameter_values(backend);
+    result = (char**)malloc(sizeof(char*) * (2 * values.size() + 1));
+    size_t i = 0;
+    for (const auto& kv : values) {
+      result[i++] = strdup(kv.first.c_str());
+      result[i++] = strdup(kv.second.c_str());
+    }
+    result[i] = NULL;
+  } catch (std::exception& e) {
+    error(e);
+  } catch (...) {
+  }
+  return result;
+}
+
 char** sjef_project_backend_names(const char* project) {
   char** result = NULL;
   bool unopened = true;
@@ -534,4 +575,60 @@ const char* sjef_project_backend_cache(const char* project) {
   }
   return nullptr;
 }
+
+char** sjef_lock_paths() {
+  char** result = NULL;
+  try {
+    auto statistics = sjef::util::Locker::all_statistics();
+    result = (char**)malloc(sizeof(char*) * (statistics.size() + 1));
+    size_t i = 0;
+    for (const auto& s : statistics)
+      result[i++] = strdup(s.path.string().c_str());
+    result[i] = NULL;
+  } catch (std::exception& e) {
+    error(e);
+  } catch (...) {
+  }
+  return result;
+}
+
+char** sjef_lock_statistics(const char* path) {
+  char** result = NULL;
+  try {
+    const auto absolute = fs::absolute(path);
+    for (const auto& s : sjef::util::Locker::all_statistics()) {
+      if (s.path != absolute)
+        continue;
+      auto histogram = [](const auto& counts) {
+        std::ostringstream ss;
+        for (size_t i = 0; i < counts.size(); ++i)
+          ss << (i > 0 ? " " : "") << counts[i];
+        return ss.str();
+      };
+      std::ostringstream owner;
+      if (s.owner != std::thread::id{})
+        owner << s.owner;
+      const std::vector<std::pair<std::string, std::string>> values{
+          {"acquisitions", std::to_string(s.acquisitions)},
+          {"shared_acquisitions", std::to_string(s.shared_acquisitions)},
+          {"total_wait_ns", std::to_string(s.total_wait.count())},
+          {"max_wait_ns", std::to_string(s.max_wait.count())},
+          {"hold_histogram", histogram(s.hold_histogram)},
+          {"shared_hold_histogram", histogram(s.shared_hold_histogram)},
+          {"owner", owner.str()},
+          {"shared_holders", std::to_string(s.shared_holders)}};
+      result = (char**)malloc(sizeof(char*) * (2 * values.size() + 1));
+      size_t i = 0;
+      for (const auto& kv : values) {
+        result[i++] = strdup(kv.first.c_str());
+        result[i++] = strdup(kv.second.c_str());
+      }
+      result[i] = NULL;
+    }
+  } catch (std::exception& e) {
+    error(e);
+  } catch (...) {
+  }
+  return result;
+}
 }
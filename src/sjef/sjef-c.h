@@ -25,6 +25,13 @@ void sjef_project_property_set(const char* project, const char* key, const char*
 void sjef_project_properties_set(const char* project, const char** key, const char** value);
 char* sjef_project_property_get(const char* project, const char* key);
 char** sjef_project_properties_get(const char* project, const char** key);
+/*!
+ * @brief Get all of the properties whose names begin with a given prefix
+ * @param project The name of the project
+ * @param prefix
+ * @return null-terminated list of pointers to malloc-allocated strings, alternately property name and value
+ */
+char** sjef_project_property_get_prefix(const char* project, const char* prefix);
 void sjef_project_property_delete(const char* project, const char* key);
 char* sjef_project_filename(const char* project);
 const char* sjef_project_backend_cache(const char* project);
@@ -58,6 +65,13 @@ void sjef_project_backend_parameter_delete(const char* project, const char* back
  * @return
  */
 char** sjef_project_backend_parameters(const char* project, const char* backend, int def);
+/*!
+ * @brief Get the values of backend parameters that have been set for a project
+ * @param project The name of the project
+ * @param backend The name of the backend
+ * @return null-terminated list of pointers to malloc-allocated strings, alternately parameter name and value
+ */
+char** sjef_project_backend_parameter_values(const char* project, const char* backend);
 char** sjef_project_backend_names(const char* project);
 // char** sjef_global_backends();
 char* sjef_expand_path(const char* path, const char* default_suffix);
@@ -117,6 +131,20 @@ void sjef_project_set_current_run(const char* project, unsigned int run);
  * @return
  */
 unsigned int sjef_project_current_run(const char* project);
+/*!
+ * @brief Get the lock files for which contention statistics have been recorded in this process
+ * @return null-terminated list of pointers to malloc-allocated paths
+ */
+char** sjef_lock_paths();
+/*!
+ * @brief Get the contention statistics recorded in this process for a lock file; see sjef::util::Locker::Statistics
+ * @param path The lock file, as given by sjef_lock_paths()
+ * @return null-terminated list of pointers to malloc-allocated strings, alternately statistic name and value, or NULL
+ * if nothing has been recorded for the lock file. The statistics are acquisitions, shared_acquisitions, total_wait_ns,
+ * max_wait_ns, hold_histogram and shared_hold_histogram (each a space-separated list of counts), owner (the thread
+ * holding an exclusive bolt, or empty) and shared_holders.
+ */
+char** sjef_lock_statistics(const char* path);
 #ifdef __cplusplus
 }
 #endif // __cplusplus
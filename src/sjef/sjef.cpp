@@ -1,7 +1,13 @@
 #include "sjef.h"
 #include "sjef-backend.h"
+#include "util/FileMonitor.h"
+#include "util/FileWatch.h"
 #include "util/Job.h"
 #include "util/Locker.h"
+#include "util/PropertyJournal.h"
+#include "util/PropertyStore.h"
+#include "util/ReplaceFile.h"
+#include "util/SharedState.h"
 #include "util/util.h"
 #include <array>
 #include <chrono>
@@ -25,7 +31,61 @@ struct sjef::pugi_xml_document : public pugi::xml_document {};
 
 ///> @private
 const std::string sjef::Project::s_propertyFile = "Info.plist";
-const std::string writing_object_file = ".Info.plist.writing_object";
+const std::string shared_state_file = ".Info.plist.state";
+const std::string property_file_new = ".Info.plist.new";
+const std::string property_journal_file = ".Info.plist.journal";
+// Earlier versions of sjef keep run_directories as a space-separated string, and imported files as IMPORTED and
+// IMPORTn, so the lists are held under other keys, and those forms are derived from them whenever the file is written
+const std::string run_directories_list = "run_directory_list";
+const std::string imports_list = "imports";
+
+///> @private
+inline std::pair<fs::file_time_type, std::uintmax_t> file_stamp(const fs::path& path) {
+  std::error_code ec;
+  const auto time = fs::last_write_time(path, ec);
+  return {time, fs::file_size(path, ec)};
+}
+
+///> @private
+inline void read_legacy_lists(sjef::util::PropertyStore& properties) {
+  // The lists are authoritative, but in a file as written, before any journal is replayed over it, the legacy forms
+  // match them unless an earlier version has changed them since, or the file comes from an earlier version
+  if (auto run_directories = properties.get("run_directories")) {
+    std::vector<std::string> values;
+    std::istringstream ss(run_directories);
+    for (std::string value; ss >> value;)
+      values.push_back(value);
+    if (values != properties.list(run_directories_list))
+      properties.list_set(run_directories_list, values);
+  }
+  if (auto imported = properties.get("IMPORTED")) {
+    std::vector<std::string> values;
+    for (int i = 0, n = std::atoi(imported); i < n; ++i)
+      if (auto value = properties.get("IMPORT" + std::to_string(i)))
+        values.emplace_back(value);
+    if (values != properties.list(imports_list))
+      properties.list_set(imports_list, values);
+  }
+}
+
+///> @private
+inline void write_legacy_lists(sjef::util::PropertyStore& properties) {
+  if (properties.list_size(run_directories_list) > 0 || properties.get("run_directories") != nullptr) {
+    std::string joined;
+    for (const auto& value : properties.list(run_directories_list))
+      joined += value + " ";
+    properties.set("run_directories", joined);
+  }
+  if (properties.list_size(imports_list) > 0 || properties.get("IMPORTED") != nullptr) {
+    const auto values = properties.list(imports_list);
+    const auto imported = properties.get("IMPORTED");
+    for (auto i = values.size(), n = imported == nullptr ? size_t(0) : size_t(std::atoi(imported)); i < n; ++i)
+      properties.erase("IMPORT" + std::to_string(i));
+    properties.set("IMPORTED", std::to_string(values.size()));
+    for (size_t i = 0; i < values.size(); ++i)
+      properties.set("IMPORT" + std::to_string(i), values[i]);
+  }
+}
 
 ///> @private
 class internal_error : public sjef::runtime_error {
@@ -47,15 +107,13 @@ bool copyDir(fs::path const& source, fs::path const& destination, bool delete_so
     throw runtime_error("Destination directory " + destination.string() + " already exists.");
   if (!fs::create_directory(destination))
     throw runtime_error("Unable to create destination directory " + destination.string());
-  sjef::util::Locker destination_locker(destination);
-  auto destination_lock = destination_locker.bolt();
   for (fs::directory_iterator file(source); file != fs::directory_iterator(); ++file) {
     fs::path current(file->path());
     if (fs::is_directory(current)) {
       if (recursive && !copyDir(current, destination / current.filename(), delete_source))
         return false;
     } else {
-      if (current.filename() != ".lock" && current.extension() != ".lock")
+      if (current.filename() != ".lock" && current.extension() != ".lock" && current.filename() != shared_state_file)
         fs::copy_file(current, destination / current.filename());
     }
   }
@@ -68,33 +126,58 @@ inline std::string getattribute(pugi::xpath_node node, const std::string& name)
   return node.node().attribute(name.c_str()).value();
 }
 
+///> @private
+// Projects on the same path share their Lockers while any of them is open; expired entries are pruned whenever the
+// registry has doubled in size since the last pruning, so that it stays proportional to the number of open projects
 std::mutex s_make_locker_mutex;
-std::map<fs::path, std::shared_ptr<util::Locker>> lockers;
-inline std::shared_ptr<util::Locker> make_locker(const fs::path& filename) {
+std::map<fs::path, std::weak_ptr<util::Locker>> lockers;
+size_t s_lockers_pruned_size = 0;
+inline std::shared_ptr<util::Locker> make_locker(const fs::path& lock_file) {
   std::lock_guard lock(s_make_locker_mutex);
-  auto name = fs::absolute(filename);
-  if (lockers.count(name) == 0) {
-    lockers[name] = std::make_shared<util::Locker>(fs::path{name} / ".lock");
+  auto name = fs::absolute(lock_file);
+  auto& entry = lockers[name];
+  auto locker = entry.lock();
+  if (!locker) {
+    locker = std::make_shared<util::Locker>(name);
+    entry = locker;
   }
-  return lockers[name];
-}
-inline void prune_lockers(const fs::path& filename) {
-  std::lock_guard lock(s_make_locker_mutex);
-  auto name = fs::absolute(filename);
-  if (lockers.count(name) > 0 && lockers[name].use_count() == 0)
-    lockers.erase(name);
+  if (lockers.size() > 2 * s_lockers_pruned_size) {
+    for (auto it = lockers.begin(); it != lockers.end();)
+      it = it->second.expired() ? lockers.erase(it) : std::next(it);
+    s_lockers_pruned_size = lockers.size();
+  }
+  return locker;
 }
-inline fs::path sjef_config_directory() {
-  return fs::path(expand_path(getenv("SJEF_CONFIG") == nullptr ? "~/.sjef" : getenv("SJEF_CONFIG")));
+///> @private
+inline size_t default_property_journal_threshold() {
+  const char* threshold = std::getenv("SJEF_PROPERTY_JOURNAL");
+  try {
+    return threshold == nullptr ? 0 : std::stoul(threshold);
+  } catch (const std::exception&) {
+    return 0;
+  }
 }
 
+///> @private
+struct Project::property_snapshot {
+  util::PropertyStore store;
+  std::uint64_t generation = 0;
+  std::uint64_t base_generation = 0;
+  size_t journal_offset = 0;
+  std::pair<fs::file_time_type, std::uintmax_t> file_stamp;
+};
+
 const std::vector<std::string> Project::suffix_keys{"inp", "out", "xml"};
 Project::Project(const std::filesystem::path& filename, bool construct, const std::string& default_suffix,
                  const mapstringstring_t& suffixes, bool record_as_recent)
     : m_project_suffix(get_project_suffix(filename, default_suffix)),
-      m_filename(expand_path(filename, m_project_suffix)), m_properties(std::make_unique<pugi_xml_document>()),
-      m_suffixes(suffixes), m_backend_doc(std::make_unique<pugi_xml_document>()), m_locker(make_locker(m_filename)),
-      m_run_directory_ignore({writing_object_file, name() + "_[^./\\\\]+\\..+"}) {
+      m_filename(expand_path(filename, m_project_suffix)), m_properties(std::make_unique<util::PropertyStore>()),
+      m_suffixes(suffixes), m_backend_doc(std::make_unique<pugi_xml_document>()), m_locker(make_locker(m_filename / ".lock")),
+      m_run_locker(make_locker(m_filename / ".run.lock")), m_sync_locker(make_locker(m_filename / ".sync.lock")),
+      m_shared_state(std::make_unique<util::SharedState>(m_filename / shared_state_file)),
+      m_property_journal(std::make_unique<util::PropertyJournal>(m_filename / property_journal_file)),
+      m_property_journal_threshold(default_property_journal_threshold()),
+      m_run_directory_ignore({shared_state_file, property_journal_file, name() + "_[^./\\\\]+\\..+"}) {
   {
     auto lock = m_locker->bolt();
     if (fs::exists(propertyFile())) {
@@ -107,7 +190,8 @@ Project::Project(const std::filesystem::path& filename, bool construct, const st
                                                 "<plist> <dict/> </plist>"
                                              << std::endl;
     }
-    auto recent_projects_directory = expand_path(sjef_config_directory() / m_project_suffix);
+    record_job_state_locked();
+    auto recent_projects_directory = expand_path(util::sjef_config_directory() / m_project_suffix);
     fs::create_directories(recent_projects_directory);
     for (const auto& key : suffix_keys)
       if (m_suffixes.count(key) < 1)
@@ -123,20 +207,16 @@ Project::Project(const std::filesystem::path& filename, bool construct, const st
       return;
     if (const auto pf = propertyFile(); !fs::exists(pf)) {
       save_property_file();
-      m_property_file_modification_time = fs::last_write_time(propertyFile());
       property_set("_status", "4");
     } else {
       if (!fs::exists(pf))
         throw runtime_error("Unexpected absence of property file " + pf.string());
-      m_property_file_modification_time = fs::last_write_time(propertyFile());
       check_property_file_locked();
     }
     custom_initialisation();
 
-    auto nimport = property_get("IMPORTED").empty() ? 0 : std::stoi(property_get("IMPORTED"));
-    for (int i = 0; i < nimport; i++) {
-      m_reserved_files.push_back(property_get(std::string{"IMPORT"} + std::to_string(i)));
-    }
+    for (const auto& imported : property_list_get(imports_list))
+      m_reserved_files.push_back(imported);
     if (record_as_recent && fs::path{m_filename}.parent_path().filename().string() != "run" &&
         !fs::exists(fs::path{m_filename}.parent_path().parent_path() /
                     "Info.plist")) // If this is a run-directory project, do not add to recent list
@@ -164,7 +244,26 @@ Project::Project(const std::filesystem::path& filename, bool construct, const st
   }
 }
 
-Project::~Project() {}
+Project::~Project() {
+  for (const auto& subscription : std::set<std::uint64_t>(m_subscriptions))
+    unsubscribe(subscription);
+  m_job.reset(); // stop any poll thread before the journal is compacted
+  if (m_property_journal_threshold == 0 || m_property_journal->size() == 0)
+    return;
+  try {
+    auto lock = m_locker->bolt();
+    check_property_file_locked();
+    rewrite_property_file_locked();
+  } catch (const std::exception& e) {
+    m_warn.error() << "failed to compact property journal: " << e.what() << std::endl;
+  }
+}
+
+void Project::set_property_journal(size_t compaction_threshold) {
+  auto lock = m_locker->bolt();
+  m_property_journal_threshold = compaction_threshold;
+  m_property_journal_pending.clear();
+}
 
 std::string Project::get_project_suffix(const std::filesystem::path& filename,
                                         const std::string& default_suffix) const {
@@ -192,10 +291,7 @@ bool Project::import_file(const std::filesystem::path& file, bool overwrite) {
     remove(to);
   fs::copy_file(file, to, ec);
   m_reserved_files.emplace_back(to.string());
-  auto nimport = property_get("IMPORTED").empty() ? 0 : std::stoi(property_get("IMPORTED"));
-  std::string key = "IMPORT" + std::to_string(nimport);
-  property_set(key, to.filename().string());
-  property_set("IMPORTED", std::to_string(nimport + 1));
+  property_list_append(imports_list, to.filename().string());
   if (ec)
     throw runtime_error(ec.message());
   return true;
@@ -225,7 +321,7 @@ bool Project::export_file(const fs::path& file, bool overwrite) {
 }
 
 void Project::force_file_names(const std::string& oldname) {
-  m_locker->bolt();
+  auto transaction = this->transaction();
   fs::directory_iterator end_iter;
   for (fs::directory_iterator dir_itr(m_filename); dir_itr != end_iter; ++dir_itr) {
     auto path = dir_itr->path();
@@ -248,6 +344,7 @@ void Project::force_file_names(const std::string& oldname) {
       throw runtime_error(dir_itr->path().string() + " " + ex.what());
     }
   }
+  transaction.commit();
 }
 
 fs::path Project::propertyFile() const { return (fs::path{m_filename} / fs::path{s_propertyFile}).string(); }
@@ -264,6 +361,13 @@ bool Project::move(const std::filesystem::path& destination_filename, bool force
     if (!copyDir(fs::path(m_filename), dest, true))
       throw runtime_error("Failed to copy current project directory");
     m_filename = dest.string();
+    m_shared_state = std::make_unique<util::SharedState>(m_filename / shared_state_file);
+    m_property_journal = std::make_unique<util::PropertyJournal>(m_filename / property_journal_file);
+    m_property_generation = m_shared_state->property_generation();
+    m_property_base_generation = m_shared_state->property_base_generation();
+    m_property_journal_offset = m_property_journal->size();
+    record_job_state_locked();
+    std::atomic_store(&m_property_snapshot, std::shared_ptr<const property_snapshot>());
     force_file_names(namesave);
     recent_edit(history ? m_filename : "", filenamesave);
     if (!fs::remove_all(filenamesave))
@@ -311,9 +415,19 @@ bool Project::copy(const std::filesystem::path& destination_filename, bool force
       fs::remove_all(dest);
     if (fs::exists(dest))
       throw runtime_error("Copy to " + dest.string() + " cannot be done because the destination already exists");
-    auto bolt = m_locker->bolt();
+    // The properties are taken from a snapshot rather than the copied file, so their lock is not needed
+    auto run_bolt = m_run_locker->shared_bolt();
+    std::optional<util::Locker::SharedBolt> sync_bolt;
+    if (!slave)
+      sync_bolt.emplace(*m_sync_locker);
     if (!copyDir(fs::path(m_filename), dest, false, !slave))
       return false;
+    // the file might not yet reflect the journal, or an open transaction on this thread
+    util::PropertyStore properties(m_transaction_thread == std::this_thread::get_id() ? *m_properties
+                                                                                       : properties_snapshot()->store);
+    write_legacy_lists(properties);
+    properties.save(dest / s_propertyFile);
+    fs::remove(dest / property_journal_file); // which is now complete
   }
   Project dp(dest.string());
   dp.force_file_names(name());
@@ -321,7 +435,7 @@ bool Project::copy(const std::filesystem::path& destination_filename, bool force
     recent_edit(dp.m_filename);
   dp.property_delete("jobnumber");
   if (slave)
-    dp.property_delete("run_directories");
+    dp.property_delete(std::vector<std::string>{run_directories_list, "run_directories"});
   dp.clean(keep_run_directories);
   if (!keep_hash)
     dp.property_delete("project_hash");
@@ -366,13 +480,31 @@ std::string Project::backend_get(const std::string& backend, const std::string&
     return be.status_running;
   else if (key == "kill_command")
     return be.kill_command;
+  else if (key == "status_batch_command")
+    return be.status_batch_command;
+  else if (key == "poll_interval_min")
+    return be.poll_interval_min;
+  else if (key == "poll_interval_max")
+    return be.poll_interval_max;
+  else if (key == "run_array_command")
+    return be.run_array_command;
   else
     throw std::out_of_range("Invalid key " + key);
 }
 
+mapstringstring_t Project::backend_parameter_values(const std::string& backend) const {
+  const auto prefix = "Backend/" + backend + "/";
+  mapstringstring_t result;
+  for (const auto& [key, value] : property_get_prefix(prefix))
+    if (auto parameter = value.substr(0, value.find("!")); !parameter.empty())
+      result[key.substr(prefix.size())] = parameter;
+  return result;
+}
+
 std::string Project::backend_parameter_expand(const std::string& backend, std::string templ) const {
   if (templ.empty())
     templ = backend_get(backend, "run_command");
+  const auto values = backend_parameter_values(backend);
   std::string output_text;
   std::regex re("[^$]\\{([^}]*)\\}");
   auto callback = [&](std::string m) {
@@ -394,7 +526,7 @@ std::string Project::backend_parameter_expand(const std::string& backend, std::s
         def = parameter_name.substr(defpos + 1);
         parameter_name.erase(defpos);
       }
-      auto value = backend_parameter_get(backend, parameter_name);
+      auto value = values.count(parameter_name) > 0 ? values.at(parameter_name) : std::string{};
       if (value.empty()) {
         if (!def.empty())
           output_text += m.substr(0, percent) + def;
@@ -456,26 +588,37 @@ mapstringstring_t Project::backend_parameters(const std::string& backend, bool d
 }
 
 bool Project::run(int verbosity, bool force, bool wait, const std::string& options) {
+  const auto command = run_prepare(verbosity, force, options);
+  if (!command)
+    return false;
+  m_job.reset(new util::Job(*this));
+  m_job->run(*command, verbosity, false);
+  record_submission(verbosity);
+  if (wait)
+    this->wait();
+  return true;
+}
+
+std::optional<std::string> Project::run_prepare(int verbosity, bool force, const std::string& options) {
 
   using util::splitString;
 
   if (auto stat = status(); stat == running || stat == waiting)
-    return false;
+    return std::nullopt;
 
   const auto& backend = m_backends.at(property_get("backend"));
   m_trace(2 - verbosity) << "Project::run() run_needed()=" << run_needed(verbosity) << std::endl;
   if (!force && !run_needed())
-    return false;
+    return std::nullopt;
   //  status(unevaluated);
   std::string line;
   std::string optionstring = options+" ";
-  property_set("run_input_hash", std::to_string(input_hash()));
   if (verbosity > 0 && backend.name != sjef::Backend::dummy_name)
     optionstring += "-v ";
   auto run_command = backend_parameter_expand(backend.name, backend.run_command);
   custom_run_preface();
-  m_job.reset(nullptr);
-  auto rundir = run_directory_new();
+  m_job.reset(nullptr); // before registering the run, since its poll task might be waiting for the property lock
+  auto rundir = run_directory_new({{"run_input_hash", std::to_string(input_hash())}});
   m_trace(3 - verbosity) << "new run directory " << rundir << std::endl;
   m_xml_cached = "";
   m_trace(2 - verbosity) << "run job, backend=" << backend.name << std::endl;
@@ -486,19 +629,63 @@ bool Project::run(int verbosity, bool force, bool wait, const std::string& optio
     optionstring = "'" + *sp + "' " + optionstring;
   m_trace(3 - verbosity) << "run job " << run_command + " " + optionstring + rundir.stem().string() + ".inp"
                          << std::endl;
-  m_job.reset(new util::Job(*this));
-  m_job->run(run_command + " " + optionstring + rundir.stem().string() + ".inp", verbosity, false);
-  property_set("jobnumber", std::to_string(m_job->job_number()));
+  return run_command + " " + optionstring + rundir.stem().string() + ".inp";
+}
+
+void Project::record_submission(int verbosity) {
+  // in microseconds, so that the time from submission to confirmation can be followed
+  std::string latencies;
+  for (const auto& [stage, latency] : m_job->submission_latencies())
+    latencies += (latencies.empty() ? "" : " ") + stage + "=" +
+                 std::to_string(std::chrono::duration_cast<std::chrono::microseconds>(latency).count());
+  mapstringstring_t properties{{"jobnumber", std::to_string(m_job->job_number())}, {"submission_latency", latencies}};
+  if (m_job->placement())
+    properties["placement"] = *m_job->placement();
+  property_set(properties);
   //    p_status_mutex.reset(); // TODO probably not necessary
   m_trace(3 - verbosity) << "jobnumber " << m_job->job_number() << std::endl;
-  if (wait)
-    this->wait();
-  return true;
+}
+
+std::vector<bool> submit_many(const std::vector<Project*>& projects, const std::string& backend, int verbosity,
+                              bool force) {
+  std::vector<bool> result;
+  std::vector<Project*> submitted;
+  std::vector<std::pair<util::Job*, std::string>> jobs;
+  std::vector<std::string> inputs;
+  for (const auto& project : projects) {
+    project->change_backend(backend);
+    const auto command = project->run_prepare(verbosity, force, "");
+    result.push_back(command.has_value());
+    if (!command)
+      continue;
+    project->m_job.reset(new util::Job(*project));
+    submitted.push_back(project);
+    jobs.emplace_back(project->m_job.get(), *command);
+    inputs.push_back(project->run_directory(0).stem().string() + ".inp"); // as in the command from run_prepare()
+  }
+  if (submitted.empty())
+    return result;
+  const auto& array_command = submitted.front()->m_backends.at(backend).run_array_command;
+  try {
+    util::Job::run_many(jobs, verbosity,
+                        array_command.empty() ? ""
+                                              : submitted.front()->backend_parameter_expand(backend, array_command),
+                        inputs);
+  } catch (...) { // those that were submitted before the failure are still recorded
+    for (const auto& project : submitted)
+      if (project->status() != failed)
+        project->record_submission(verbosity);
+    throw;
+  }
+  for (const auto& project : submitted)
+    project->record_submission(verbosity);
+  return result;
 }
 
 void Project::clean(int keep_run_directories) {
   if (auto statuss = status(); statuss == running || statuss == waiting)
     keep_run_directories = std::max(keep_run_directories, 1);
+  auto lock = m_run_locker->bolt();
   while (run_list().size() > size_t(keep_run_directories))
     run_delete(1);
 }
@@ -620,12 +807,26 @@ std::string Project::file_contents(const std::string& suffix, const std::string&
   return result;
 }
 
-sjef::status Project::status() const {
-  auto current_status = property_get("_status");
+sjef::status Project::status() const { return status_with_patience(std::nullopt); }
+
+sjef::status Project::status(std::chrono::milliseconds patience) const {
+  return status_with_patience(std::optional<std::chrono::milliseconds>(patience));
+}
+
+sjef::status Project::status_with_patience(std::optional<std::chrono::milliseconds> patience) const {
+  if (auto recorded = m_shared_state->job_status())
+    return static_cast<sjef::status>(*recorded);
+  auto current_status = property_get_with_patience({"_status"}, patience)["_status"];
   return current_status.empty() ? unevaluated : static_cast<sjef::status>(std::stoi(current_status));
 }
 
-std::string sjef::Project::status_message(int verbosity) const {
+std::string sjef::Project::status_message(int verbosity) const { return status_message_with_patience(verbosity, std::nullopt); }
+
+std::string sjef::Project::status_message(int verbosity, std::chrono::milliseconds patience) const {
+  return status_message_with_patience(verbosity, std::optional<std::chrono::milliseconds>(patience));
+}
+
+std::string sjef::Project::status_message_with_patience(int verbosity, std::optional<std::chrono::milliseconds> patience) const {
   std::map<sjef::status, std::string> message;
   message[sjef::status::unknown] = "Not found";
   message[sjef::status::running] = "Running";
@@ -634,23 +835,36 @@ std::string sjef::Project::status_message(int verbosity) const {
   message[sjef::status::unevaluated] = "Unevaluated";
   message[sjef::status::killed] = "Killed";
   message[sjef::status::failed] = "Failed";
-  auto statu = this->status();
+  auto statu = status_with_patience(patience);
   auto result = message[statu];
-  if (statu != sjef::status::unknown && !property_get("jobnumber").empty())
-    result += ", job number " + property_get("jobnumber") + " on backend " + property_get("backend");
+  auto job = property_get_with_patience({"jobnumber", "backend"}, patience);
+  if (statu != sjef::status::unknown && !job["jobnumber"].empty())
+    result += ", job number " + job["jobnumber"] + " on backend " + job["backend"];
   return result;
 }
 
+std::chrono::system_clock::time_point Project::last_poll_time() const { return m_shared_state->last_poll_time(); }
+
+std::chrono::system_clock::time_point Project::last_sync_time() const { return m_shared_state->last_sync_time(); }
+
 void Project::wait(unsigned int maximum_microseconds) const {
   if (m_job == nullptr)
     m_job.reset(new util::Job(*this));
-  unsigned int microseconds = 1;
-  //  std::cout << "wait status="<<status()<<std::endl;
-  while (status() == unknown or status() == running or status() == waiting) {
-    //    std::cout << "in sjef::Project::wait() status "<<status()<<std::endl;
-    std::this_thread::sleep_for(std::chrono::microseconds(microseconds));
-    if (microseconds < maximum_microseconds)
-      microseconds *= 2;
+  const auto timeout = std::chrono::microseconds(maximum_microseconds);
+  auto finished = [this]() {
+    auto stat = status();
+    return stat != unknown and stat != running and stat != waiting;
+  };
+  // Whichever process changes the status touches the shared state file, so watching it catches every change; without
+  // a file watch, fall back to the notification made when this Project's own Job changes the status
+  util::FileWatch watch(m_filename / shared_state_file);
+  while (!finished()) {
+    if (watch.active())
+      watch.wait_for(timeout);
+    else {
+      std::unique_lock lock(m_status_mutex);
+      m_status_changed.wait_for(lock, timeout, finished);
+    }
   }
   m_job.reset(nullptr);
   //  std::cout << "wait status="<<status()<<std::endl;
@@ -659,46 +873,91 @@ void Project::wait(unsigned int maximum_microseconds) const {
 void Project::property_delete(const std::vector<std::string>& properties) {
   auto lock = m_locker->bolt();
   check_property_file_locked();
+  bool changed = false;
   for (const auto& property : properties)
-    property_delete_locked(property);
-  save_property_file_locked();
+    if (m_properties->erase(property)) {
+      changed = true;
+      if (m_property_journal_threshold > 0)
+        m_property_journal_pending += util::PropertyJournal::erase_record(property);
+    }
+  if (changed) {
+    save_property_file_locked();
+    record_job_state_locked();
+  }
 }
 
 void Project::property_delete(const std::string& property) { // TODO make atomic
   property_delete(std::vector<std::string>{property});
 }
 
-void Project::property_delete_locked(const std::string& property) {
-  if (!m_properties->child("plist"))
-    m_properties->append_child("plist");
-  if (!m_properties->child("plist").child("dict"))
-    m_properties->child("plist").append_child("dict");
-  auto dict = m_properties->child("plist").child("dict");
-  std::string query{"//key[text()='" + property + "']"};
-  auto nodes = dict.select_nodes(query.c_str());
-  for (const auto& keynode : nodes) {
-    auto valnode = keynode.node().select_node("following-sibling::string[1]");
-    dict.remove_child(keynode.node());
-    dict.remove_child(valnode.node());
+Project::Transaction::Transaction(Project& project)
+    : m_project(project), m_uncaught_exceptions(std::uncaught_exceptions()) {
+  m_project.m_locker->add_bolt();
+  try {
+    if (m_project.m_transaction_depth == 0) {
+      m_project.check_property_file_locked();
+      m_project.m_transaction_thread = std::this_thread::get_id();
+    }
+  } catch (...) {
+    m_project.m_locker->remove_bolt();
+    throw;
+  }
+  ++m_project.m_transaction_depth;
+}
+
+Project::Transaction::~Transaction() {
+  if (!m_open)
+    return;
+  try {
+    finish(std::uncaught_exceptions() <= m_uncaught_exceptions);
+  } catch (const std::exception& e) {
+    m_project.m_warn.error() << "failed to complete property transaction: " << e.what() << std::endl;
   }
 }
 
+void Project::Transaction::commit() {
+  if (m_open)
+    finish(true);
+}
+
+void Project::Transaction::finish(bool keep) {
+  m_open = false;
+  if (--m_project.m_transaction_depth == 0)
+    m_project.m_transaction_thread = std::thread::id();
+  try {
+    if (m_project.m_transaction_depth == 0 && m_project.m_transaction_dirty) {
+      m_project.m_transaction_dirty = false;
+      if (keep) {
+        try {
+          m_project.save_property_file_locked();
+        } catch (...) { // so that the properties in memory are those in the file
+          try {
+            m_project.load_property_file_locked();
+          } catch (...) {
+          }
+          throw;
+        }
+      } else
+        m_project.load_property_file_locked();
+      m_project.record_job_state_locked();
+    }
+  } catch (...) {
+    m_project.m_locker->remove_bolt();
+    throw;
+  }
+  m_project.m_locker->remove_bolt();
+}
+
 void Project::property_set(const mapstringstring_t& properties) {
   auto lock = m_locker->bolt();
   check_property_file_locked();
   for (const auto& [property, value] : properties) {
-    property_delete_locked(property);
-    std::lock_guard guard(m_unmovables.m_property_set_mutex);
-    if (!m_properties->child("plist"))
-      m_properties->append_child("plist");
-    if (!m_properties->child("plist").child("dict"))
-      m_properties->child("plist").append_child("dict");
-    auto keynode = m_properties->child("plist").child("dict").append_child("key");
-    keynode.text() = property.c_str();
-    auto stringnode = m_properties->child("plist").child("dict").append_child("string");
-    stringnode.text() = value.c_str();
+    m_properties->set(property, value);
+    if (m_property_journal_threshold > 0)
+      m_property_journal_pending += util::PropertyJournal::set_record(property, value);
   }
   save_property_file_locked();
+  record_job_state_locked();
 }
 
 void Project::property_set(const std::string& property, const std::string& value) { property_set({{property, value}}); }
@@ -707,25 +966,198 @@ std::string Project::property_get(const std::string& property) const {
   return property_get(std::vector<std::string>{property})[property];
 }
 mapstringstring_t Project::property_get(const std::vector<std::string>& properties) const {
-  check_property_file();
+  return property_get_with_patience(properties, std::nullopt);
+}
+std::string Project::property_get(const std::string& property, std::chrono::milliseconds patience) const {
+  return property_get(std::vector<std::string>{property}, patience)[property];
+}
+mapstringstring_t Project::property_get(const std::vector<std::string>& properties,
+                                        std::chrono::milliseconds patience) const {
+  return property_get_with_patience(properties, std::optional<std::chrono::milliseconds>(patience));
+}
+mapstringstring_t Project::property_get_with_patience(const std::vector<std::string>& properties,
+                                                     std::optional<std::chrono::milliseconds> patience) const {
   mapstringstring_t results;
-  for (const std::string& property : properties) {
-    std::string query{"/plist/dict/key[text()='" + property + "']/following-sibling::string[1]"};
-    auto xpath_node = m_properties->select_node(query.c_str());
-    auto node = xpath_node.node();
-    std::string value = node.child_value();
-    if (!value.empty())
-      results[property] = value;
+  auto lookup = [&](const util::PropertyStore& store) {
+    for (const std::string& property : properties)
+      if (auto value = store.get(property); value != nullptr && *value != '\0')
+        results[property] = value;
+  };
+  if (m_transaction_thread == std::this_thread::get_id()) { // see the uncommitted state of our own transaction
+    lookup(*m_properties);
+    return results;
   }
+  lookup(properties_snapshot(patience)->store);
   return results;
 }
 
 std::vector<std::string> Project::property_names() const {
-  check_property_file();
-  std::vector<std::string> result;
-  for (const auto& node : m_properties->select_nodes((std::string{"/plist/dict/key"}).c_str()))
-    result.push_back(node.node().child_value());
-  return result;
+  if (m_transaction_thread == std::this_thread::get_id())
+    return m_properties->names();
+  return properties_snapshot()->store.names();
+}
+
+mapstringstring_t Project::property_get_prefix(const std::string& prefix) const {
+  if (m_transaction_thread == std::this_thread::get_id())
+    return m_properties->prefixed(prefix);
+  return properties_snapshot()->store.prefixed(prefix);
+}
+
+std::vector<std::string> Project::property_list_get(const std::string& property) const {
+  if (m_transaction_thread == std::this_thread::get_id())
+    return m_properties->list(property);
+  return properties_snapshot()->store.list(property);
+}
+
+std::string Project::property_list_get(const std::string& property, size_t index) const {
+  auto lookup = [&](const util::PropertyStore& store) {
+    auto value = store.list_get(property, index);
+    return std::string{value == nullptr ? "" : value};
+  };
+  if (m_transaction_thread == std::this_thread::get_id())
+    return lookup(*m_properties);
+  return lookup(properties_snapshot()->store);
+}
+
+size_t Project::property_list_size(const std::string& property) const {
+  if (m_transaction_thread == std::this_thread::get_id())
+    return m_properties->list_size(property);
+  return properties_snapshot()->store.list_size(property);
+}
+
+void Project::property_list_set(const std::string& property, const std::vector<std::string>& values) {
+  auto lock = m_locker->bolt();
+  check_property_file_locked();
+  m_properties->list_set(property, values);
+  if (m_property_journal_threshold > 0)
+    m_property_journal_pending += util::PropertyJournal::list_record(property, values);
+  save_property_file_locked();
+}
+
+void Project::property_list_append(const std::string& property, const std::string& value) {
+  auto lock = m_locker->bolt();
+  check_property_file_locked();
+  m_properties->list_append(property, value);
+  if (m_property_journal_threshold > 0)
+    m_property_journal_pending += util::PropertyJournal::list_append_record(property, value);
+  save_property_file_locked();
+}
+
+void Project::property_list_erase(const std::string& property, size_t index) {
+  auto lock = m_locker->bolt();
+  check_property_file_locked();
+  if (!m_properties->list_erase(property, index))
+    return;
+  if (m_property_journal_threshold > 0)
+    m_property_journal_pending += util::PropertyJournal::list_erase_record(property, index);
+  save_property_file_locked();
+}
+
+std::uint64_t Project::subscribe(const std::vector<std::string>& keys,
+                                 std::function<void(const mapstringstring_t& changed)> callback) {
+  auto last = std::make_shared<mapstringstring_t>(property_get(keys));
+  // property commits touch the shared state file, so that watching it catches every change
+  auto subscription = util::FileMonitor::instance().add(
+      m_filename / shared_state_file, [this, keys, last, callback = std::move(callback)]() {
+        auto current = property_get(keys);
+        mapstringstring_t changed;
+        for (const auto& key : keys) {
+          auto value = current.count(key) > 0 ? current[key] : std::string{};
+          if (value != (last->count(key) > 0 ? last->at(key) : std::string{}))
+            changed[key] = value;
+        }
+        if (changed.empty())
+          return;
+        *last = std::move(current);
+        callback(changed);
+      });
+  std::lock_guard lock(m_subscriptions_mutex);
+  m_subscriptions.insert(subscription);
+  return subscription;
+}
+
+void Project::unsubscribe(std::uint64_t subscription) {
+  {
+    std::lock_guard lock(m_subscriptions_mutex);
+    if (m_subscriptions.erase(subscription) == 0)
+      return;
+  }
+  util::FileMonitor::instance().remove(subscription);
+}
+
+std::shared_ptr<const Project::property_snapshot>
+Project::properties_snapshot(std::optional<std::chrono::milliseconds> patience) const {
+  auto snapshot = std::atomic_load(&m_property_snapshot);
+  const auto deadline = std::chrono::steady_clock::now() + patience.value_or(std::chrono::milliseconds(0));
+  auto remaining = [&deadline]() {
+    return std::max<std::chrono::steady_clock::duration>(deadline - std::chrono::steady_clock::now(), {});
+  };
+  auto stale = [&snapshot]() {
+    return snapshot != nullptr ? snapshot : std::make_shared<const property_snapshot>();
+  };
+  std::optional<util::Locker::SharedBolt> bolt;
+  for (int attempt = 0;; ++attempt) {
+    auto reload = [&]() -> std::shared_ptr<const property_snapshot> {
+      bolt.reset();
+      auto lock = patience ? m_locker->bolt_for(remaining()) : m_locker->bolt();
+      if (!lock)
+        return stale();
+      check_property_file_locked();
+      publish_properties_snapshot_locked();
+      return std::atomic_load(&m_property_snapshot);
+    };
+    const auto generation = m_shared_state->property_generation();
+    if (snapshot != nullptr && snapshot->generation == generation)
+      return snapshot->file_stamp == file_stamp(propertyFile()) ? snapshot : reload();
+    // The file is always replaced by rename, and the journal only appended to or emptied, so both can be read without
+    // the lock; if another save happens meanwhile, the generation will have moved on and the result is discarded.
+    // Under a stream of writers that could go on indefinitely, so eventually they are held off with a shared bolt.
+    if (attempt == 3) {
+      if (!patience)
+        bolt.emplace(*m_locker);
+      else if (!bolt.emplace(*m_locker, remaining()))
+        return stale();
+    }
+    const auto base_generation = m_shared_state->property_base_generation();
+    // a rewrite is in progress, so the file and journal may not match; but under the bolt, the mark can only have been
+    // left by a writer that died
+    if (base_generation > generation && !bolt.has_value()) {
+      std::this_thread::yield();
+      continue;
+    }
+    std::shared_ptr<property_snapshot> fresh;
+    std::optional<size_t> journal_offset;
+    if (snapshot != nullptr && snapshot->base_generation == base_generation) {
+      fresh = std::make_shared<property_snapshot>(*snapshot);
+      journal_offset = m_property_journal->replay(fresh->store, snapshot->journal_offset);
+    }
+    if (!journal_offset) {
+      fresh = std::make_shared<property_snapshot>();
+      fresh->file_stamp = file_stamp(propertyFile()); // before loading, so that a change meanwhile is noticed later
+      if (!fresh->store.load(propertyFile()).empty()) // perhaps written in place by something other than sjef
+        return reload();
+      read_legacy_lists(fresh->store);
+      journal_offset = m_property_journal->replay(fresh->store);
+    }
+    // a rewrite that began meanwhile may have replaced the file under a replay of the old journal, whose list appends
+    // would then be applied twice
+    if (!journal_offset || m_shared_state->property_generation() != generation ||
+        m_shared_state->property_base_generation() != base_generation)
+      continue;
+    fresh->generation = generation;
+    fresh->base_generation = base_generation;
+    fresh->journal_offset = *journal_offset;
+    std::shared_ptr<const property_snapshot> result = fresh;
+    std::atomic_compare_exchange_strong(&m_property_snapshot, &snapshot, result);
+    return result;
+  }
+}
+
+void Project::publish_properties_snapshot_locked() const {
+  auto snapshot = std::make_shared<property_snapshot>(property_snapshot{
+      *m_properties, m_property_generation, m_property_base_generation, m_property_journal_offset,
+      m_property_file_stamp});
+  std::atomic_store(&m_property_snapshot, std::shared_ptr<const property_snapshot>(std::move(snapshot)));
 }
 
 inline std::string slurp(const std::filesystem::path& path) {
@@ -739,7 +1171,7 @@ std::mutex s_recent_edit_mutex;
 void Project::recent_edit(const std::filesystem::path& add, const std::filesystem::path& remove) {
   auto project_suffix =
       add.empty() ? fs::path(remove).extension().string().substr(1) : fs::path(add).extension().string().substr(1);
-  const auto recent_projects_file = sjef_config_directory() / project_suffix / "projects";
+  const auto recent_projects_file = util::sjef_config_directory() / project_suffix / "projects";
   auto recent_projects_file_ = recent_projects_file;
   recent_projects_file_ += "-";
   bool changed = false;
@@ -805,81 +1237,88 @@ std::filesystem::path Project::run_directory(int run) const {
   auto sequence = run_verify(run);
   if (sequence < 1)
     return filename(); // covers the case of projects without run directories
-  auto dirlist = run_list();
-  auto dir = fs::path{filename()} / "run" / (dirlist[sequence - 1] + "." + m_project_suffix);
+  auto dir =
+      fs::path{filename()} / "run" / (property_list_get(run_directories_list, sequence - 1) + "." + m_project_suffix);
   if (!fs::is_directory(dir))
     throw runtime_error("Cannot find directory " + dir.string());
   return dir.string();
 }
-fs::path Project::run_directory_new() {
-  auto dirlist = run_list();
-  std::string stem;
-  for (auto seq = int(dirlist.size() + 1); true; ++seq) {
-    stem = run_directory_basename(seq);
-    if (std::find(dirlist.begin(), dirlist.end(), stem) == dirlist.end())
+fs::path Project::run_directory_new(const mapstringstring_t& properties) {
+  // The directory is registered only once it has been populated, and the property lock is not held while copying;
+  // the run bolt is taken first, since run directories are locked before properties
+  auto lock = m_run_locker->bolt();
+  auto rundir = fs::path{filename()} / "run";
+  fs::path dir;
+  for (auto seq = int(property_list_size(run_directories_list) + 1); true; ++seq) {
+    dir = rundir / (run_directory_basename(seq) + "." + m_project_suffix);
+    if (!fs::exists(dir))
       break;
   }
-  dirlist.push_back(stem);
-  std::stringstream ss;
-  for (const auto& dir : dirlist)
-    ss << dir << " ";
-  property_set("run_directories", ss.str());
-  auto rundir = fs::path{filename()} / "run";
-  auto dir = rundir / (stem + "." + m_project_suffix);
   if (!fs::exists(rundir) && !fs::create_directories(rundir)) {
     throw runtime_error("Cannot create directory " + rundir.string());
   }
+  copy(dir.string(), false, false, true);
+  { // the copy has the properties from before this run, so is given those of the run itself
+    auto run_properties = properties;
+    run_properties["current_run"] = "0";
+    Project(dir).property_set(run_properties);
+  }
+  auto transaction = this->transaction();
+  if (!properties.empty())
+    property_set(properties);
   property_delete("jobnumber");
   set_current_run(0);
-  copy(dir.string(), false, false, true);
+  property_list_append(run_directories_list, dir.stem().string());
+  transaction.commit();
   return dir;
 }
 
 void Project::run_delete(int run) {
   if (status() == running or status() == waiting)
     throw runtime_error("Cannot delete run directory when job is running or waiting");
+  auto lock = m_run_locker->bolt();
   run = run_verify(run);
   if (run == 0)
     return;
-  fs::remove_all(run_directory(run));
-  auto dirlist = run_list();
-  std::stringstream ss;
-  for (size_t i = 0; i < dirlist.size(); ++i) {
-    ss << dirlist[i] << " ";
-  }
+  // the entry is removed even if the directory has already gone
+  fs::remove_all(fs::path{filename()} / "run" /
+                 (property_list_get(run_directories_list, run - 1) + "." + m_project_suffix));
+  property_list_erase(run_directories_list, run - 1);
 }
 
 int Project::run_verify(int run) const {
-  auto runlist = run_list();
+  // run_list() forgets any directories that have gone, so that the rest are numbered as they are found
+  const auto runs = run_list().size();
   if (run > 0)
-    return (runlist.size() >= size_t(run)) ? run : 0;
+    return (runs >= size_t(run)) ? run : 0;
   const auto currentRun = current_run();
   if (currentRun > 0)
     return currentRun;
-  else if (runlist.empty())
-    return 0;
   else
-    return runlist.size();
+    return runs;
 }
 
 Project::run_list_t Project::run_list() const {
+  auto existing = [this](run_list_t& rundirs) {
+    const auto property = property_list_get(run_directories_list);
+    rundirs.clear();
+    for (const auto& value : property)
+      if (fs::exists(fs::path{m_filename} / "run" / (value + "." + m_project_suffix)))
+        rundirs.push_back(value);
+    return rundirs.size() == property.size();
+  };
   run_list_t rundirs;
-  const std::string& property = property_get("run_directories");
-  auto ss = std::stringstream(property);
-  std::string value;
-  std::string new_property;
-  while (ss >> value && !ss.eof())
-    if (fs::exists(fs::path{m_filename} / "run" / (value + "." + m_project_suffix))) {
-      rundirs.push_back(value);
-      new_property += value + " ";
-    }
-  if (new_property != property)
-    const_cast<Project*>(this)->property_set("run_directories", new_property);
+  if (existing(rundirs))
+    return rundirs;
+  // forget missing directories only under the lock, since run_delete() might be between removing one and its entry
+  auto lock = m_run_locker->bolt();
+  if (!existing(rundirs))
+    const_cast<Project*>(this)->property_list_set(run_directories_list, rundirs);
   return rundirs;
 }
 
 int Project::recent_find(const std::string& suffix, const std::filesystem::path& filename) {
-  auto recent_projects_directory = expand_path(sjef_config_directory() / suffix);
+  auto recent_projects_directory = expand_path(util::sjef_config_directory() / suffix);
   fs::create_directories(recent_projects_directory);
   std::ifstream in(expand_path(recent_projects_directory / "projects"));
   std::string line;
@@ -898,7 +1337,7 @@ int Project::recent_find(const std::filesystem::path& filename) const {
 }
 
 std::string Project::recent(const std::string& suffix, int number) {
-  auto recent_projects_directory = expand_path(sjef_config_directory() / suffix);
+  auto recent_projects_directory = expand_path(util::sjef_config_directory() / suffix);
   fs::create_directories(recent_projects_directory);
   //  std::cout << "recent_projects_directory " << recent_projects_directory << std::endl;
   std::ifstream in(expand_path(recent_projects_directory / "projects"));
@@ -914,53 +1353,36 @@ std::string Project::recent(const std::string& suffix, int number) {
 
 std::string Project::recent(int number) const { return recent(m_project_suffix, number); }
 
-///> @private
-struct plist_writer : pugi::xml_writer {
-  std::string file;
-  void write(const void* data, size_t size) override {
-    std::ofstream s(file);
-    s << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
-      << "<!DOCTYPE plist SYSTEM '\"-//Apple//DTD PLIST 1.0//EN\" "
-         "\"http://www.apple.com/DTDs/PropertyList-1.0.dtd\"'>\n"
-      << std::string{static_cast<const char*>(data), size};
-  }
-};
-
-constexpr static bool use_writer = false;
 void Project::load_property_file_locked() const {
-  if (auto result = m_properties->load_file(propertyFile().c_str()); !result)
-    throw runtime_error("error in loading " + propertyFile().string() + "\n" + result.description() + "\n" +
-                        slurp(propertyFile()));
-  m_property_file_modification_time = fs::last_write_time(propertyFile());
+  auto generation = m_shared_state->property_generation();
+  m_property_file_stamp = file_stamp(propertyFile());
+  if (auto error = m_properties->load(propertyFile()); !error.empty())
+    throw runtime_error("error in loading " + propertyFile().string() + "\n" + error + "\n" + slurp(propertyFile()));
+  read_legacy_lists(*m_properties);
+  m_property_journal_offset = m_property_journal->replay(*m_properties).value_or(0);
+  m_property_journal_pending.clear();
+  m_property_generation = generation;
+  m_property_base_generation = m_shared_state->property_base_generation();
+  publish_properties_snapshot_locked();
 }
 
-bool Project::properties_last_written_by_me(bool removeFile) const {
-  auto path = fs::path{m_filename} / fs::path{writing_object_file};
-  auto lock = m_locker->bolt();
-  std::ifstream i{path.string(), std::ios_base::in};
-  if (!i.is_open())
-    return false;
-  std::hash<const Project*> hasher;
-  auto me = hasher(this);
-  decltype(me) writer;
-  i >> writer;
-  if (removeFile && writer == me)
-    fs::remove(path);
-  return writer == me;
-}
-void Project::check_property_file() const {
-  auto lock = m_locker->bolt();
-
-  check_property_file_locked();
-}
 void Project::check_property_file_locked() const {
-  auto lastwrite = fs::last_write_time(propertyFile());
-  if (m_property_file_modification_time == lastwrite && !properties_last_written_by_me(false))
-    m_property_file_modification_time -= std::chrono::milliseconds(1);
-  if (m_property_file_modification_time < lastwrite) {
-    load_property_file_locked();
-    m_property_file_modification_time = lastwrite;
+  if (m_transaction_depth > 0) // the in-memory properties are authoritative until the transaction completes
+    return;
+  const auto generation = m_shared_state->property_generation();
+  if (generation == m_property_generation) {
+    if (file_stamp(propertyFile()) != m_property_file_stamp) // rewritten without going through the shared state
+      load_property_file_locked();
+    return;
   }
+  if (m_shared_state->property_base_generation() == m_property_base_generation) // only the journal has grown
+    if (auto offset = m_property_journal->replay(*m_properties, m_property_journal_offset)) {
+      m_property_journal_offset = *offset;
+      m_property_generation = generation;
+      publish_properties_snapshot_locked();
+      return;
+    }
+  load_property_file_locked();
 }
 
 void Project::save_property_file() const {
@@ -968,20 +1390,58 @@ void Project::save_property_file() const {
   save_property_file_locked();
 }
 void Project::save_property_file_locked() const {
-  struct plist_writer writer;
-  writer.file = propertyFile().string();
-  if (!fs::exists(propertyFile())) {
-    fs::create_directories(m_filename);
-    { std::ofstream x(propertyFile()); }
+  if (m_transaction_depth > 0) {
+    m_transaction_dirty = true;
+    return;
   }
-  if (use_writer)
-    m_properties->save(writer, "\t", pugi::format_no_declaration);
-  else
-    m_properties->save_file(propertyFile().c_str());
-  auto path = (fs::path{m_filename} / fs::path{writing_object_file});
-  std::ofstream o{path.string()};
-  std::hash<const Project*> hasher;
-  o << hasher(this);
+  if (m_property_journal_threshold > 0 && !m_property_journal_pending.empty() &&
+      m_property_journal_offset + m_property_journal_pending.size() <= m_property_journal_threshold) {
+    m_property_journal_offset = m_property_journal->append(m_property_journal_pending);
+    m_property_journal_pending.clear();
+    // Rather than copying every property into a new snapshot, leave the old one to be brought up to date by replaying
+    // the journal when it is next read
+    m_property_generation = m_shared_state->advance_property_generation(false);
+    m_shared_state->touch();
+    return;
+  }
+  rewrite_property_file_locked();
+}
+
+void Project::rewrite_property_file_locked() const {
+  // write a complete new file and rename it into place, so that readers never see a partially-written file
+  fs::create_directories(m_filename);
+  const auto new_file = fs::path{m_filename} / property_file_new;
+  write_legacy_lists(*m_properties);
+  if (!m_properties->save(new_file))
+    throw runtime_error("Cannot write property file " + new_file.string());
+  m_shared_state->begin_property_rewrite();
+  try {
+    util::replace_file(new_file, propertyFile());
+  } catch (...) { // the file and journal are unchanged, and readers need only load them afresh
+    m_property_generation = m_property_base_generation = m_shared_state->advance_property_generation();
+    throw;
+  }
+  m_property_file_stamp = file_stamp(propertyFile());
+  m_property_journal->clear();
+  m_property_journal_offset = 0;
+  m_property_journal_pending.clear();
+  m_property_generation = m_property_base_generation = m_shared_state->advance_property_generation();
+  m_shared_state->touch();
+  publish_properties_snapshot_locked();
+}
+
+void Project::record_job_state_locked() const {
+  if (m_transaction_depth > 0) // recorded when the transaction is committed
+    return;
+  const auto status = m_properties->get("_status");
+  if (m_shared_state->set_job_status(status == nullptr || *status == '\0'
+                                         ? std::nullopt
+                                         : std::optional<int>{static_cast<int>(std::strtol(status, nullptr, 10))})) {
+    { std::lock_guard lock(m_status_mutex); } // so that a waiter cannot miss the notification
+    m_status_changed.notify_all();
+  }
+  const auto jobnumber = m_properties->get("jobnumber");
+  m_shared_state->set_job_number(jobnumber == nullptr ? 0 : std::strtoll(jobnumber, nullptr, 10));
 }
 
 ///> @private
@@ -1185,6 +1645,14 @@ void Project::add_backend(const std::string& name, const mapstringstring_t& fiel
     m_backends[name].status_waiting = fields.at("status_waiting");
   if (fields.count("kill_command") > 0)
     m_backends[name].kill_command = fields.at("kill_command");
+  if (fields.count("status_batch_command") > 0)
+    m_backends[name].status_batch_command = fields.at("status_batch_command");
+  if (fields.count("poll_interval_min") > 0)
+    m_backends[name].poll_interval_min = fields.at("poll_interval_min");
+  if (fields.count("poll_interval_max") > 0)
+    m_backends[name].poll_interval_max = fields.at("poll_interval_max");
+  if (fields.count("run_array_command") > 0)
+    m_backends[name].run_array_command = fields.at("run_array_command");
   save_backend_config(m_backends, m_project_suffix);
 }
 
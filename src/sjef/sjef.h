@@ -7,11 +7,17 @@
 using boost::alignment::aligned_alloc;
 #endif
 #endif
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
 #include <filesystem>
+#include <functional>
 #include <iostream>
 #include <map>
 #include <memory>
 #include <mutex>
+#include <optional>
 #include <ostream>
 #include <set>
 #include <sjef/util/Logger.h>
@@ -25,7 +31,10 @@ class xpath_node_set; ///< @private
 namespace sjef {
 namespace util {
 class Job;
-class Locker; ///< @private
+class Locker;        ///< @private
+class PropertyJournal; ///< @private
+class PropertyStore;   ///< @private
+class SharedState;     ///< @private
 } // namespace util
 class Backend; ///< @private
 using util::Locker;
@@ -42,27 +51,33 @@ private:
                                     ///< pathname for the directory holding the bundle
   std::vector<std::filesystem::path> m_reserved_files = std::vector<std::filesystem::path>{
       sjef::Project::s_propertyFile}; ///< Files which should never be copied back from backend
-  std::unique_ptr<pugi_xml_document> m_properties;
+  std::unique_ptr<util::PropertyStore> m_properties;
   mapstringstring_t m_suffixes; ///< File suffixes for the standard files
   std::map<std::string, Backend> m_backends;
 
   std::unique_ptr<pugi_xml_document> m_backend_doc;
-  // put the flag into a container to deal conveniently with std:atomic_flag's
-  // lack of move constructor
-  struct unmovables_container {
-    std::mutex m_property_set_mutex;
-  };
-  mutable unmovables_container m_unmovables;
   mutable std::string m_backend; ///< The current backend
   mutable std::string m_xml_cached;
   ///> @private
   static const std::string s_propertyFile;
   ///> @private
-  std::shared_ptr<Locker> m_locker;
+  // Each lock domain has its own lock file, so that a long operation in one does not hold up the others. A thread
+  // holding more than one takes them in the order run directories, output sync, properties.
+  std::shared_ptr<Locker> m_locker;      ///< the property file, journal and shared state
+  std::shared_ptr<Locker> m_run_locker;  ///< the set of run directories
+  std::shared_ptr<Locker> m_sync_locker; ///< synchronisation of the run directory with the backend
+  std::unique_ptr<util::SharedState> m_shared_state; ///< cross-process record of the property file generation
+  std::unique_ptr<util::PropertyJournal> m_property_journal;
   mutable Logger m_warn{std::cerr, Logger::Levels::warning, {"sjef:: Error: ", "sjef:: Warning: ", "sjef:: Note:"}};
   mutable Logger m_trace{std::cout, Logger::Levels::quiet};
   friend class util::Job;
   mutable std::unique_ptr<util::Job> m_job;
+  //! Everything in run() before the job is submitted; returns the command to submit, or nothing if there is no need
+  std::optional<std::string> run_prepare(int verbosity, bool force, const std::string& options);
+  //! Record the job number and submission latencies of m_job
+  void record_submission(int verbosity);
+  friend std::vector<bool> submit_many(const std::vector<Project*>& projects, const std::string& backend,
+                                       int verbosity, bool force);
 
 public:
   /*!
@@ -184,16 +199,41 @@ public:
    * - 5 killed
    */
   sjef::status status() const;
+  /*!
+   * @brief Obtain the status of the job started by run(), waiting no longer than a given time for the project lock
+   * @param patience How long to wait if the lock is needed to read the current status. If it cannot be obtained in
+   * time, the status last seen by this Project is returned, which might be stale.
+   * @return
+   */
+  sjef::status status(std::chrono::milliseconds patience) const;
   /*!
    *
    * @return An informative string about job status
    */
   std::string status_message(int verbosity = 0) const;
+  /*!
+   * @brief An informative string about job status, waiting no longer than a given time for the project lock
+   * @param verbosity
+   * @param patience How long to wait if the lock is needed to read the current status. If it cannot be obtained in
+   * time, the message reflects what was last seen by this Project, which might be stale.
+   * @return
+   */
+  std::string status_message(int verbosity, std::chrono::milliseconds patience) const;
+  /*!
+   * @brief When the status of the job was last obtained from its backend, by any process
+   * @return The time, or the epoch of std::chrono::system_clock if the job has not been polled
+   */
+  std::chrono::system_clock::time_point last_poll_time() const;
+  /*!
+   * @brief When the run directory was last synchronised with the cache on a remote backend, by any process
+   * @return The time, or the epoch of std::chrono::system_clock if it has not been synchronised
+   */
+  std::chrono::system_clock::time_point last_sync_time() const;
   /*!
    * @brief Wait unconditionally for status() to return neither 'waiting' nor
-   * 'running'
-   * @param maximum_microseconds The poll interval is successively increased
-   * between calls to status() until reaching this value.
+   * 'running'. The wait is woken when the status changes, whether the change is made in this process or another.
+   * @param maximum_microseconds The longest interval between calls to status(), as a safeguard against a change of
+   * status that was not notified.
    */
   void wait(unsigned int maximum_microseconds = 10000) const;
   /*!
@@ -295,6 +335,23 @@ public:
    * @return For each property found, a key-value pair
    */
   mapstringstring_t property_get(const std::vector<std::string>& properties) const;
+  /*!
+   * @brief Get the value of a property, waiting no longer than a given time for the project lock
+   * @param property
+   * @param patience How long to wait if the lock is needed to read the current value, for example because another
+   * process is rewriting the property file. If it cannot be obtained in time, the value last seen by this Project is
+   * returned, which might be stale.
+   * @return The value, or "" if key does not exist
+   */
+  std::string property_get(const std::string& property, std::chrono::milliseconds patience) const;
+  /*!
+   * @brief Get the values of several properties, waiting no longer than a given time for the project lock
+   * @param properties
+   * @param patience How long to wait if the lock is needed to read the current values. If it cannot be obtained in
+   * time, the values last seen by this Project are returned, which might be stale.
+   * @return For each property found, a key-value pair
+   */
+  mapstringstring_t property_get(const std::vector<std::string>& properties, std::chrono::milliseconds patience) const;
   /*!
    * @brief Remove a variable
    * @param property
@@ -306,6 +363,107 @@ public:
    * @return
    */
   std::vector<std::string> property_names() const;
+  /*!
+   * @brief Get all properties whose names begin with a prefix, for example <tt>Backend/slurm/</tt>
+   * @param prefix
+   * @return The names, in full, and values of the properties. List-valued properties are not included.
+   */
+  mapstringstring_t property_get_prefix(const std::string& prefix) const;
+  /*!
+   * @brief Get all the elements of a list-valued property
+   * @param property
+   * @return The elements, or an empty vector if the property is not a list
+   */
+  std::vector<std::string> property_list_get(const std::string& property) const;
+  /*!
+   * @brief Get one element of a list-valued property
+   * @param property
+   * @param index Counting from zero
+   * @return The element, or an empty string if there is no such element
+   */
+  std::string property_list_get(const std::string& property, size_t index) const;
+  /*!
+   * @brief Get the number of elements of a list-valued property
+   * @param property
+   * @return The number of elements, or zero if the property is not a list
+   */
+  size_t property_list_size(const std::string& property) const;
+  /*!
+   * @brief Set a list-valued property, replacing any existing value
+   * @param property
+   * @param values
+   */
+  void property_list_set(const std::string& property, const std::vector<std::string>& values);
+  /*!
+   * @brief Append an element to a list-valued property, which is created if necessary
+   * @param property
+   * @param value
+   */
+  void property_list_append(const std::string& property, const std::string& value);
+  /*!
+   * @brief Remove an element of a list-valued property
+   * @param property
+   * @param index Counting from zero
+   */
+  void property_list_erase(const std::string& property, size_t index);
+  /*!
+   * @brief Be told whenever any of a set of properties changes, whether the change is made in this process or another.
+   * The callbacks for all projects run on a single thread shared by the whole process, so should return quickly.
+   * @param keys The properties of interest
+   * @param callback Called with the new values of those properties that have changed, a deleted property having an
+   * empty value
+   * @return An identifier for unsubscribe()
+   */
+  std::uint64_t subscribe(const std::vector<std::string>& keys,
+                          std::function<void(const mapstringstring_t& changed)> callback);
+  /*!
+   * @brief Stop the callbacks requested by subscribe(). Once this returns, the callback is not running, and will not
+   * be called again.
+   * @param subscription The identifier returned by subscribe()
+   */
+  void unsubscribe(std::uint64_t subscription);
+  /*!
+   * @brief RAII scope in which changes to properties are batched.
+   * While the outermost Transaction exists, the project lock is held, and property_set() and property_delete() change
+   * only the in-memory properties. The property file is written once, when the outermost Transaction is committed, or
+   * not at all if nothing was changed. A Transaction that has not been committed is committed when it is destroyed, but
+   * then a failure to save is only logged; if its scope is left through an exception, the changes are discarded instead.
+   * Transactions may be nested, and are bound to the thread that opened them.
+   * The lock held is that on the properties alone, so a transaction should not enclose operations that create or
+   * remove run directories, or synchronise with the backend, which take their own locks first.
+   */
+  class Transaction {
+  public:
+    explicit Transaction(Project& project);
+    ~Transaction();
+    Transaction(const Transaction&) = delete;
+    Transaction& operator=(const Transaction&) = delete;
+    /*!
+     * @brief End the transaction, saving the changes if it is the outermost one. Nothing more is done when it is
+     * destroyed.
+     * @throws std::exception if the changes cannot be saved, in which case they are discarded
+     */
+    void commit();
+
+  private:
+    Project& m_project;
+    const int m_uncaught_exceptions;
+    bool m_open = true;
+    void finish(bool keep);
+  };
+  /*!
+   * @brief Open a transaction on the project properties
+   * @return The object whose lifetime delimits the transaction
+   */
+  Transaction transaction() { return Transaction(*this); }
+  /*!
+   * @brief Choose whether property changes are saved by appending them to a journal beside the property file, instead
+   * of rewriting the whole file. The journal is folded back into the property file when it would grow beyond the
+   * threshold, and when the Project is destroyed. The initial setting is taken from the environment variable
+   * SJEF_PROPERTY_JOURNAL if it is set, otherwise the journal is not used.
+   * @param compaction_threshold The maximum size in bytes of the journal, or zero to disable it
+   */
+  void set_property_journal(size_t compaction_threshold);
   /*!
    * @brief Get the file name of the bundle, or a primary file of particular
    * type, or a general file in the bundle
@@ -338,7 +496,7 @@ public:
    */
   int run_verify(int run) const;
   /*!
-   * @brief Obtain the list of run directory names
+   * @brief Obtain the list of run directory names. Any whose directory no longer exists are forgotten.
    * @return
    */
   using run_list_t = std::vector<std::string>;
@@ -346,9 +504,10 @@ public:
   /*!
    * @brief Create a new run directory. Also copy into it the input file, and
    * any of its dependencies
+   * @param properties Properties to set in the same transaction that registers the new run directory
    * @return The sequence number of the new run directory
    */
-  std::filesystem::path run_directory_new();
+  std::filesystem::path run_directory_new(const mapstringstring_t& properties = {});
   /*!
    * @brief Delete a run directory
    * @param run
@@ -394,16 +553,40 @@ private:
   std::string get_project_suffix(const std::filesystem::path& filename, const std::string& default_suffix) const;
 
   static void recent_edit(const std::filesystem::path& add, const std::filesystem::path& remove = "");
-  mutable std::filesystem::file_time_type m_property_file_modification_time;
+  mutable std::uint64_t m_property_generation = 0; ///< the generation of the property file last loaded or saved
+  mutable std::uint64_t m_property_base_generation = 0; ///< the generation at which the file was last rewritten
+  //! The modification time and size of the property file when last loaded or rewritten, by which a writer that bypasses
+  //! the shared state, such as an earlier version of sjef, an editor or git, is noticed
+  mutable std::pair<std::filesystem::file_time_type, std::uintmax_t> m_property_file_stamp;
+  mutable size_t m_property_journal_offset = 0;         ///< how much of the journal has been applied to m_properties
+  mutable std::string m_property_journal_pending;       ///< journal records for changes not yet saved
+  size_t m_property_journal_threshold = 0;
+  mutable int m_transaction_depth = 0;
+  mutable bool m_transaction_dirty = false;
+  mutable std::atomic<std::thread::id> m_transaction_thread; ///< the thread owning an open transaction, if any
+  struct property_snapshot;
+  ///> The properties as last committed, shared immutably with readers; access only through std::atomic_load/store
+  mutable std::shared_ptr<const property_snapshot> m_property_snapshot;
+  std::shared_ptr<const property_snapshot>
+  properties_snapshot(std::optional<std::chrono::milliseconds> patience = std::nullopt) const;
+  // Named apart from the public overloads, so that a patience of any duration type is not ambiguous
+  mapstringstring_t property_get_with_patience(const std::vector<std::string>& properties,
+                                               std::optional<std::chrono::milliseconds> patience) const;
+  sjef::status status_with_patience(std::optional<std::chrono::milliseconds> patience) const;
+  std::string status_message_with_patience(int verbosity, std::optional<std::chrono::milliseconds> patience) const;
+  void publish_properties_snapshot_locked() const;
   mutable std::map<std::string, std::filesystem::file_time_type, std::less<>> m_input_file_modification_time;
   std::set<std::string, std::less<>> m_run_directory_ignore;
-  void property_delete_locked(const std::string& property);
   void check_property_file_locked() const;
-  void check_property_file() const;
   void save_property_file_locked() const;
   void save_property_file() const;
   void load_property_file_locked() const;
-  bool properties_last_written_by_me(bool removeFile = false) const;
+  void rewrite_property_file_locked() const;
+  void record_job_state_locked() const;
+  mutable std::mutex m_status_mutex;
+  mutable std::condition_variable m_status_changed; ///< notified when this Project changes the recorded job status
+  std::mutex m_subscriptions_mutex;
+  std::set<std::uint64_t> m_subscriptions;
 
 public:
   std::filesystem::path propertyFile() const;
@@ -497,6 +680,13 @@ public:
     return p.substr(0, p.find("!"));
   }
 
+  /*!
+   * @brief Get the values of all the parameters of a backend that have been set, as by backend_parameter_get()
+   * @param backend The name of the backend
+   * @return The parameter names and values
+   */
+  mapstringstring_t backend_parameter_values(const std::string& backend) const;
+
   /*!
    * @brief Return the documentation associated with a backend run parameter
    * @param backend The name of the backend
@@ -618,6 +808,19 @@ public:
  */
 bool check_backends(const std::string& suffix);
 
+/*!
+ * @brief Start jobs for several projects on the same backend, as Project::run() would for each, but copying their run
+ * directories to a remote backend in a single transfer. If the backend has a run_array_command, all the jobs are
+ * submitted with that one command.
+ * @param projects
+ * @param backend The name of the backend, which each project is changed to
+ * @param verbosity
+ * @param force Whether to run each project even though run_needed() reports that it's unnecessary
+ * @return Whether each project was submitted
+ */
+std::vector<bool> submit_many(const std::vector<Project*>& projects, const std::string& backend, int verbosity = 0,
+                              bool force = false);
+
 /*!
  * @brief Edit a file path name
  * - expand environment variables
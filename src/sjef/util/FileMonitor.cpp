@@ -0,0 +1,124 @@
+#include "FileMonitor.h"
+#include <stdexcept>
+#include <vector>
+#ifdef __linux__
+#include <cerrno>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace sjef::util {
+
+FileMonitor& FileMonitor::instance() {
+  static auto* monitor = new FileMonitor(); // never destroyed, since projects may outlive static destruction
+  return *monitor;
+}
+
+FileMonitor::FileMonitor() {
+#ifdef __linux__
+  m_fd = inotify_init1(IN_CLOEXEC);
+#endif
+  std::thread thread([this]() { run(); });
+  m_thread_id = thread.get_id();
+  thread.detach();
+}
+
+FileMonitor::id_t FileMonitor::add(const std::filesystem::path& file, callback_t callback) {
+  std::lock_guard lock(m_mutex);
+  if (m_watches.count(file) == 0) {
+    std::error_code ec;
+    watch new_watch{-1, std::filesystem::last_write_time(file, ec)};
+#ifdef __linux__
+    if (m_fd >= 0) {
+      new_watch.descriptor = inotify_add_watch(m_fd, file.string().c_str(), IN_ATTRIB | IN_MODIFY | IN_CLOSE_WRITE);
+      if (new_watch.descriptor < 0)
+        throw std::runtime_error("Cannot watch file " + file.string());
+    }
+#endif
+    m_watches.emplace(file, new_watch);
+  }
+  m_callbacks.emplace(m_next_id, std::make_pair(file, std::move(callback)));
+  return m_next_id++;
+}
+
+void FileMonitor::remove(id_t id) {
+  {
+    std::lock_guard lock(m_mutex);
+    auto callback = m_callbacks.find(id);
+    if (callback == m_callbacks.end())
+      return;
+    const auto file = callback->second.first;
+    m_callbacks.erase(callback);
+    for (const auto& other : m_callbacks)
+      if (other.second.first == file)
+        return;
+#ifdef __linux__
+    if (m_fd >= 0)
+      inotify_rm_watch(m_fd, m_watches.at(file).descriptor);
+#endif
+    m_watches.erase(file);
+  }
+  if (std::this_thread::get_id() != m_thread_id)
+    std::lock_guard dispatch(m_dispatch_mutex);
+}
+
+void FileMonitor::dispatch(const std::set<std::filesystem::path>& files) {
+  std::lock_guard dispatch(m_dispatch_mutex);
+  std::vector<callback_t> callbacks;
+  {
+    std::lock_guard lock(m_mutex);
+    for (const auto& callback : m_callbacks)
+      if (files.count(callback.second.first) > 0)
+        callbacks.push_back(callback.second.second);
+  }
+  for (const auto& callback : callbacks)
+    try {
+      callback();
+    } catch (...) { // there is nobody to report to
+    }
+}
+
+void FileMonitor::run() {
+#ifdef __linux__
+  if (m_fd >= 0) {
+    alignas(inotify_event) char buffer[4096];
+    while (true) {
+      auto length = read(m_fd, buffer, sizeof(buffer));
+      if (length <= 0) {
+        if (errno == EINTR)
+          continue;
+        return;
+      }
+      std::set<std::filesystem::path> files;
+      {
+        std::lock_guard lock(m_mutex);
+        for (auto event = buffer; event < buffer + length;
+             event += sizeof(inotify_event) + reinterpret_cast<const inotify_event*>(event)->len)
+          for (const auto& watch : m_watches)
+            if (watch.second.descriptor == reinterpret_cast<const inotify_event*>(event)->wd)
+              files.insert(watch.first);
+      }
+      dispatch(files);
+    }
+  }
+#endif
+  while (true) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    std::set<std::filesystem::path> files;
+    {
+      std::lock_guard lock(m_mutex);
+      for (auto& watch : m_watches) {
+        std::error_code ec;
+        auto modified = std::filesystem::last_write_time(watch.first, ec);
+        if (!ec && modified != watch.second.modified) {
+          watch.second.modified = modified;
+          files.insert(watch.first);
+        }
+      }
+    }
+    if (!files.empty())
+      dispatch(files);
+  }
+}
+
+} // namespace sjef::util
@@ -0,0 +1,61 @@
+#ifndef SJEF_LIB_UTIL_FILEMONITOR_H_
+#define SJEF_LIB_UTIL_FILEMONITOR_H_
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <set>
+#include <thread>
+
+namespace sjef::util {
+/*!
+ * @brief A single thread per process that calls back when watched files change, including changes made by other
+ * processes.
+ *
+ * Any number of callbacks may be registered on any number of files; a file watched by several callbacks is watched only
+ * once. Changes are detected with inotify where it is available, and otherwise by checking the modification time of
+ * each file periodically. Callbacks run on the monitor's thread, one at a time, and should return quickly.
+ */
+class FileMonitor {
+public:
+  using callback_t = std::function<void()>;
+  using id_t = std::uint64_t;
+  /*!
+   * @brief The monitor for this process, whose thread is started when first needed
+   */
+  static FileMonitor& instance();
+  /*!
+   * @brief Start calling back whenever a file's contents or attributes change
+   * @param file The file, which must already exist
+   * @param callback
+   * @return An identifier for remove()
+   */
+  id_t add(const std::filesystem::path& file, callback_t callback);
+  /*!
+   * @brief Stop calling back. Unless called from a callback, waits for any callback in progress to finish, so that
+   * whatever the callback refers to may then be destroyed.
+   * @param id As returned by add()
+   */
+  void remove(id_t id);
+
+private:
+  FileMonitor();
+  ~FileMonitor() = delete; // the monitor lives until the process ends
+  void run();
+  void dispatch(const std::set<std::filesystem::path>& files);
+  struct watch {
+    int descriptor;
+    std::filesystem::file_time_type modified;
+  };
+  std::mutex m_mutex;          ///< protects the maps
+  std::mutex m_dispatch_mutex; ///< held while callbacks run
+  std::map<std::filesystem::path, watch> m_watches;
+  std::map<id_t, std::pair<std::filesystem::path, callback_t>> m_callbacks;
+  id_t m_next_id = 1;
+  int m_fd = -1;
+  std::thread::id m_thread_id;
+};
+
+} // namespace sjef::util
+#endif // SJEF_LIB_UTIL_FILEMONITOR_H_
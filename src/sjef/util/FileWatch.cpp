@@ -0,0 +1,47 @@
+#include "FileWatch.h"
+#include <thread>
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace sjef::util {
+
+#ifdef __linux__
+FileWatch::FileWatch(const std::filesystem::path& file) : m_fd(inotify_init1(IN_NONBLOCK | IN_CLOEXEC)) {
+  if (m_fd >= 0)
+    m_watch = inotify_add_watch(m_fd, file.string().c_str(), IN_ATTRIB | IN_MODIFY | IN_CLOSE_WRITE);
+}
+
+FileWatch::~FileWatch() {
+  if (m_fd >= 0)
+    close(m_fd);
+}
+
+bool FileWatch::wait_for(std::chrono::microseconds timeout) {
+  if (!active()) {
+    std::this_thread::sleep_for(timeout);
+    return false;
+  }
+  pollfd descriptor{m_fd, POLLIN, 0};
+  const auto milliseconds = std::chrono::ceil<std::chrono::milliseconds>(timeout).count();
+  if (poll(&descriptor, 1, static_cast<int>(milliseconds)) <= 0)
+    return false;
+  alignas(inotify_event) char buffer[4096];
+  while (read(m_fd, buffer, sizeof(buffer)) > 0) // drain, so that the next call waits for a new change
+    ;
+  return true;
+}
+#else
+FileWatch::FileWatch(const std::filesystem::path& file) {}
+
+FileWatch::~FileWatch() = default;
+
+bool FileWatch::wait_for(std::chrono::microseconds timeout) {
+  std::this_thread::sleep_for(timeout);
+  return false;
+}
+#endif
+
+} // namespace sjef::util
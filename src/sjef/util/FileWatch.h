@@ -0,0 +1,38 @@
+#ifndef SJEF_LIB_UTIL_FILEWATCH_H_
+#define SJEF_LIB_UTIL_FILEWATCH_H_
+#include <chrono>
+#include <filesystem>
+
+namespace sjef::util {
+/*!
+ * @brief Notification of changes to the contents or attributes of a file, including those made by other processes.
+ *
+ * Events are collected from the moment of construction, so that a change made between construction and a call to
+ * wait_for() is not missed. The mechanism is inotify, and on systems without it the watch is inactive: wait_for()
+ * then simply sleeps for the timeout, and callers should check whatever they are waiting for afterwards anyway.
+ */
+class FileWatch {
+public:
+  explicit FileWatch(const std::filesystem::path& file);
+  ~FileWatch();
+  FileWatch(const FileWatch&) = delete;
+  FileWatch& operator=(const FileWatch&) = delete;
+
+  /*!
+   * @brief Whether changes to the file can be detected
+   */
+  bool active() const { return m_watch >= 0; }
+  /*!
+   * @brief Block until the file changes, or the timeout expires
+   * @param timeout
+   * @return true if the file has changed since construction or the previous call
+   */
+  bool wait_for(std::chrono::microseconds timeout);
+
+private:
+  int m_fd = -1;
+  int m_watch = -1;
+};
+
+} // namespace sjef::util
+#endif // SJEF_LIB_UTIL_FILEWATCH_H_
@@ -0,0 +1,116 @@
+#include "HostCapabilities.h"
+#include "../sjef.h"
+#include "Locker.h"
+#include "ReplaceFile.h"
+#include "util.h"
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+namespace fs = std::filesystem;
+
+namespace sjef::util {
+
+///> @private
+inline std::chrono::system_clock::duration host_cache_ttl() {
+  const char* ttl = std::getenv("SJEF_HOST_CACHE_TTL");
+  try {
+    if (ttl != nullptr)
+      return std::chrono::duration_cast<std::chrono::system_clock::duration>(
+          std::chrono::duration<double>(std::stod(ttl)));
+  } catch (const std::exception&) {
+  }
+  return std::chrono::hours(24);
+}
+
+HostCapabilities& HostCapabilities::instance() {
+  // one for each configuration directory, which can be changed while running
+  static std::mutex mutex;
+  static auto* capabilities = new std::map<fs::path, std::unique_ptr<HostCapabilities>>;
+  const auto file = sjef_config_directory() / "host-capabilities";
+  std::lock_guard lock(mutex);
+  auto& result = (*capabilities)[file];
+  if (!result)
+    result.reset(new HostCapabilities(file));
+  return *result;
+}
+
+HostCapabilities::HostCapabilities(fs::path file) : m_file(std::move(file)), m_ttl(host_cache_ttl()) {}
+
+HostCapabilities::facts_t HostCapabilities::read() const {
+  facts_t facts;
+  std::ifstream stream(m_file);
+  for (std::string line; std::getline(stream, line);) {
+    std::istringstream fields(line);
+    std::string time, host, key, value;
+    if (std::getline(fields, time, '\t') && std::getline(fields, host, '\t') && std::getline(fields, key, '\t') &&
+        std::getline(fields, value)) {
+      try {
+        facts[{host, key}] = {value, clock::time_point(std::chrono::seconds(std::stoll(time)))};
+      } catch (const std::exception&) {
+      }
+    }
+  }
+  return facts;
+}
+
+HostCapabilities::stamp_t HostCapabilities::stamp() const {
+  std::error_code ec;
+  return {fs::last_write_time(m_file, ec), fs::file_size(m_file, ec)};
+}
+
+std::optional<std::string> HostCapabilities::get(const std::string& host, const std::string& key) {
+  std::lock_guard lock(m_mutex);
+  if (const auto file_stamp = stamp(); file_stamp != m_file_stamp) { // another process has changed it
+    m_facts = read();
+    m_file_stamp = file_stamp;
+  }
+  const auto fact = m_facts.find({host, key});
+  if (fact == m_facts.end() or clock::now() - fact->second.second > m_ttl)
+    return std::nullopt;
+  return fact->second.first;
+}
+
+template <typename Change>
+void HostCapabilities::update(Change change) {
+  std::lock_guard lock(m_mutex);
+  try {
+    fs::create_directories(m_file.parent_path());
+    Locker locker(fs::path{m_file}.concat(".lock"));
+    auto bolt = locker.bolt();
+    auto facts = read();
+    change(facts);
+    const auto now = clock::now();
+    const auto new_file = fs::path{m_file}.concat(".new");
+    {
+      std::ofstream stream(new_file);
+      for (auto fact = facts.begin(); fact != facts.end();) {
+        if (now - fact->second.second > m_ttl) {
+          fact = facts.erase(fact);
+          continue;
+        }
+        stream << std::chrono::duration_cast<std::chrono::seconds>(fact->second.second.time_since_epoch()).count()
+               << '\t' << fact->first.first << '\t' << fact->first.second << '\t' << fact->second.first << '\n';
+        ++fact;
+      }
+    }
+    replace_file(new_file, m_file);
+    m_facts = std::move(facts);
+    m_file_stamp = stamp();
+  } catch (const std::exception&) { // the cache is only an optimisation
+  }
+}
+
+void HostCapabilities::set(const std::string& host, const std::string& key, const std::string& value) {
+  update([&](facts_t& facts) { facts[{host, key}] = {value, clock::now()}; });
+}
+
+void HostCapabilities::forget(const std::string& host, const std::string& key) {
+  update([&](facts_t& facts) {
+    for (auto fact = facts.begin(); fact != facts.end();)
+      fact = (fact->first.first == host and (key.empty() or fact->first.second == key)) ? facts.erase(fact)
+                                                                                        : std::next(fact);
+  });
+}
+
+} // namespace sjef::util
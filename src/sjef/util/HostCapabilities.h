@@ -0,0 +1,71 @@
+#ifndef SJEF_LIB_UTIL_HOSTCAPABILITIES_H_
+#define SJEF_LIB_UTIL_HOSTCAPABILITIES_H_
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <utility>
+
+namespace sjef::util {
+/*!
+ * @brief What has been learned about remote hosts, such as where rsync is found there and which cache directories
+ * exist, so that it need not be asked for each time a Job is constructed.
+ *
+ * Facts are kept in memory and in the file host-capabilities in the sjef configuration directory, which is shared by
+ * all processes. Each fact is forgotten once it is older than the time to live, given in seconds by the environment
+ * variable SJEF_HOST_CACHE_TTL, and otherwise one day.
+ */
+class HostCapabilities {
+public:
+  /*!
+   * @brief The capabilities recorded in the current sjef configuration directory
+   */
+  static HostCapabilities& instance();
+  /*!
+   * @brief A fact about a host, if it is known and has not expired
+   * @param host
+   * @param key
+   */
+  std::optional<std::string> get(const std::string& host, const std::string& key);
+  /*!
+   * @brief Record a fact about a host
+   * @param host
+   * @param key
+   * @param value
+   */
+  void set(const std::string& host, const std::string& key, const std::string& value);
+  /*!
+   * @brief Forget a fact about a host, for example because it has been found to be no longer true
+   * @param host
+   * @param key If empty, forget everything about the host
+   */
+  void forget(const std::string& host, const std::string& key = "");
+  /*!
+   * @brief The file in which the facts are kept
+   */
+  const std::filesystem::path& file() const { return m_file; }
+
+private:
+  explicit HostCapabilities(std::filesystem::path file);
+  using clock = std::chrono::system_clock;
+  using facts_t = std::map<std::pair<std::string, std::string>, std::pair<std::string, clock::time_point>>;
+  //! Merge the file with the facts in memory, and apply a change to both
+  template <typename Change>
+  void update(Change change);
+  facts_t read() const;
+  const std::filesystem::path m_file;
+  const clock::duration m_ttl;
+  std::mutex m_mutex; ///< protects m_facts and the file within this process
+  facts_t m_facts;
+  using stamp_t = std::pair<std::filesystem::file_time_type, std::uintmax_t>;
+  //! The modification time and size of the file when it was last read or written, since timestamps can be coarse
+  std::optional<stamp_t> m_file_stamp;
+  stamp_t stamp() const;
+};
+
+} // namespace sjef::util
+#endif // SJEF_LIB_UTIL_HOSTCAPABILITIES_H_
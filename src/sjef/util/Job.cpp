@@ -1,16 +1,24 @@
 #include "Job.h"
+#include "HostCapabilities.h"
+#include "LocalSlots.h"
+#include "Locker.h"
+#include "SharedState.h"
 #include "Shell.h"
 #include "util.h"
+#include <algorithm>
 #include <chrono>
+#include <condition_variable>
+#include <exception>
 #include <fstream>
 #include <functional>
-#include <future>
+#include <list>
 #include <regex>
 #include <set>
 #include <signal.h>
 #include <sstream>
 #include <stdlib.h>
 #include <string>
+#include <utility>
 #if defined(WIN32) || defined(__WIN64)
 #if defined(_M_AMD64) || defined(_M_X64)
 #define _AMD64_
@@ -27,26 +35,131 @@ namespace sjef::util {
 ///> @private
 const bool Job::localhost() const { return (m_backend.host.empty() || m_backend.host == "localhost"); }
 
-std::mutex kill_mutex;
+///> @private
+struct status_batch {
+  std::mutex mutex;
+  std::condition_variable query_finished;
+  std::multiset<int> jobs;      ///< the job numbers to be queried
+  std::uint64_t queries = 0;    ///< the number of queries started
+  std::uint64_t query_done = 0; ///< the latest query to have finished
+  bool querying = false;
+  std::string output; ///< the output of query number query_done
+  std::set<JobMonitor::id_t> waiting; ///< the polling tasks to wake when the query in progress finishes
+};
+
+///> @private
+static std::shared_ptr<status_batch> status_batch_for(const Backend& backend) {
+  static std::mutex mutex;
+  static std::map<std::string, std::weak_ptr<status_batch>> batches;
+  std::lock_guard lock(mutex);
+  auto& batch = batches[backend.host + "\n" + backend.status_batch_command];
+  auto result = batch.lock();
+  if (!result) {
+    result = std::make_shared<status_batch>();
+    batch = result;
+  }
+  return result;
+}
+
+///> @private
+static JobMonitor::clock::duration seconds(const std::string& value, JobMonitor::clock::duration fallback) {
+  try {
+    if (!value.empty())
+      return std::chrono::duration_cast<JobMonitor::clock::duration>(std::chrono::duration<double>(std::stod(value)));
+  } catch (const std::exception&) {
+  }
+  return fallback;
+}
+
+///> @private
+struct poll_statistics_registry {
+  std::mutex mutex;
+  std::map<std::string, Job::PollStatistics> backends;
+};
+
+///> @private
+static poll_statistics_registry& poll_statistics_by_backend() {
+  static poll_statistics_registry registry;
+  return registry;
+}
+
+///> @private
+static size_t local_processes(const Project& project, const Backend& backend) {
+  // the number of processes asked for through the conventional parameter n, which sizes the job's share of the cores
+  auto n = project.backend_parameter_get(backend.name, "n");
+  if (n.empty())
+    n = project.backend_parameter_default(backend.name, "n");
+  try {
+    return size_t(std::max(1, std::stoi(n)));
+  } catch (const std::exception&) {
+    return 1;
+  }
+}
+
+///> @private
+struct local_queue_registry {
+  std::mutex mutex;
+  std::set<JobMonitor::id_t> tasks; ///< the polling tasks of jobs waiting for a local slot
+};
+
+///> @private
+static local_queue_registry& local_queue() {
+  static local_queue_registry registry;
+  return registry;
+}
+
+///> @private
+static void wake_local_queue() {
+  auto& queue = local_queue();
+  std::lock_guard lock(queue.mutex);
+  for (const auto& task : queue.tasks)
+    JobMonitor::instance().wake(task);
+}
+
+///> @private
+static void leave_local_queue(JobMonitor::id_t task) {
+  auto& queue = local_queue();
+  std::lock_guard lock(queue.mutex);
+  queue.tasks.erase(task);
+}
+
+std::map<std::string, Job::PollStatistics> Job::poll_statistics() {
+  auto& registry = poll_statistics_by_backend();
+  std::lock_guard lock(registry.mutex);
+  return registry.backends;
+}
+
 sjef::util::Job::Job(const sjef::Project& project)
     : m_project(project), m_backend(m_project.backends().at(m_project.property_get("backend"))),
       m_remote_cache_directory(m_backend.cache + "/" +
                                std::to_string(std::hash<std::string>{}(m_project.filename("", "", 0).string()))),
+      m_poll_interval_min(seconds(m_backend.poll_interval_min, JobMonitor::clock::duration::zero())),
+      m_poll_interval_max(seconds(m_backend.poll_interval_max, std::chrono::seconds(5))),
       m_backend_command_server(new Shell(m_backend.host)),
       m_job_number(std::stoi("0" + m_project.property_get("jobnumber"))),
       m_initial_status(static_cast<sjef::status>(std::stoi("0" + m_project.property_get("_status")))) {
   //  std::cout << "Job constructor, m_job_number=" << m_job_number << std::endl;
   if (!localhost()) {
-    m_remote_rsync =
-        (*m_backend_command_server)("PATH=$HOME/bin:/usr/local/bin:/opt/homebrew/bin:/opt/bin:$PATH which rsync");
-    if (m_remote_rsync.empty())
-      m_remote_rsync = "rsync";
-    m_remote_rsync_version = (*m_backend_command_server)(m_remote_rsync + " --version|head -1");
-    m_remote_rsync_version =
-        std::regex_replace(m_remote_rsync_version, std::regex{R"( *rsync *version *([0-9.]*) .*)"}, "$1");
-    if (std::stoi(m_remote_rsync_version.substr(0, 1)) < 3)
-      throw std::runtime_error("rsync on remote " + m_backend.host + " (" + m_remote_rsync + ") is version " +
-                               m_remote_rsync_version + ", which is too old");
+    auto& capabilities = HostCapabilities::instance();
+    const auto remote_rsync = capabilities.get(m_backend.host, "rsync");
+    const auto remote_rsync_version = capabilities.get(m_backend.host, "rsync_version");
+    if (remote_rsync and remote_rsync_version) {
+      m_remote_rsync = *remote_rsync;
+      m_remote_rsync_version = *remote_rsync_version;
+    } else {
+      m_remote_rsync =
+          (*m_backend_command_server)("PATH=$HOME/bin:/usr/local/bin:/opt/homebrew/bin:/opt/bin:$PATH which rsync");
+      if (m_remote_rsync.empty())
+        m_remote_rsync = "rsync";
+      m_remote_rsync_version = (*m_backend_command_server)(m_remote_rsync + " --version|head -1");
+      m_remote_rsync_version =
+          std::regex_replace(m_remote_rsync_version, std::regex{R"( *rsync *version *([0-9.]*) .*)"}, "$1");
+      if (std::stoi(m_remote_rsync_version.substr(0, 1)) < 3)
+        throw std::runtime_error("rsync on remote " + m_backend.host + " (" + m_remote_rsync + ") is version " +
+                                 m_remote_rsync_version + ", which is too old");
+      capabilities.set(m_backend.host, "rsync", m_remote_rsync);
+      capabilities.set(m_backend.host, "rsync_version", m_remote_rsync_version);
+    }
     //        std::cout << "remote rsync: " << m_remote_rsync << std::endl;
     // don't allow remote cache directory name that could lead to shell expansion
     //    std::cout << m_remote_cache_directory<<std::endl;
@@ -54,8 +167,16 @@ sjef::util::Job::Job(const sjef::Project& project)
       throw std::runtime_error("Invalid remote cache directory " + m_remote_cache_directory);
     ensure_remote_cache_directory(); // to ensure cache is set up before any polling
   }
-  m_poll_task = std::async(std::launch::async, [this]() { this->poll_job(); });
-  //  std::cout << "Job constructor has launched poll task" << std::endl;
+  // jobs that the local machine runs itself, rather than submits to a scheduler, share its slots
+  m_local_slots = localhost() and m_backend.run_jobnumber == "([0-9]+)";
+  if (!m_backend.status_batch_command.empty())
+    m_status_batch = status_batch_for(m_backend);
+#ifdef __linux__
+  // the default status_command runs ps, which can be answered from /proc instead
+  else if (localhost() and m_backend.status_command == Backend(Backend::local()).status_command)
+    m_local_process_status = true;
+#endif
+  start_polling();
 }
 
 void setup_rsync_path() {
@@ -96,10 +217,12 @@ static std::string system_specific_ssh_options() {
 std::tuple<bool, std::string, std::string> sjef::util::Job::push_rundir(int verbosity) {
   if (localhost())
     return {true, "", ""};
+  auto lock = m_project.m_sync_locker->bolt();
   setup_rsync_path();
   std::string command = "rsync --archive --copy-links --timeout=5 -s -v";
   command += " --rsync-path=" + m_remote_rsync;
-  command += " --exclude=Info.plist --exclude=.Info.plist.writing_object";
+  command += " --exclude=Info.plist --exclude=.Info.plist.state --exclude=.Info.plist.journal";
+  command += " --exclude=.Info.plist.new --exclude=*.lock";
   command += " " + system_specific_ssh_options();
 #ifdef WIN32
   // rsync interprets c:\a\b as a remote filename so windows filenames cause it to fail
@@ -124,6 +247,7 @@ std::tuple<bool, std::string, std::string> sjef::util::Job::push_rundir(int verb
     rsync_out = shell(command, true, ".", verbosity);
   } catch (const sjef::util::Shell::runtime_error& e) {
     std::cout << "caught exception in Job::push_rundir(): " << e.what() << std::endl;
+    HostCapabilities::instance().forget(m_backend.host); // so that the next Job checks again
     throw sync_error(e.what());
   }
   if (verbosity > 1)
@@ -133,30 +257,43 @@ std::tuple<bool, std::string, std::string> sjef::util::Job::push_rundir(int verb
         << "ms" << std::endl
         << "Output from rsync\n:" << rsync_out << std::endl
         << "Error stream from rsync\n:" << shell.err() << std::endl;
-  return {shell.err().find("rsync error:") == std::string::npos, shell.out(),
-          shell.err()}; // TODO: implement more robust error checking
+  // TODO: implement more robust error checking
+  const bool success = shell.err().find("rsync error:") == std::string::npos;
+  if (success)
+    m_project.m_shared_state->set_last_sync_time(std::chrono::system_clock::now());
+  else
+    HostCapabilities::instance().forget(m_backend.host);
+  return {success, shell.out(), shell.err()};
 }
 
 void sjef::util::Job::ensure_remote_cache_directory() const {
   if (m_remote_cache_directory_verified)
     return;
+  auto& capabilities = HostCapabilities::instance();
+  if (capabilities.get(m_backend.host, "directory " + m_remote_cache_directory)) {
+    m_remote_cache_directory_verified = true;
+    return;
+  }
   (*m_backend_command_server)("mkdir -p '" + m_remote_cache_directory + "'");
   auto test_remote_cache_directory = (*m_backend_command_server)("ls -d '" + m_remote_cache_directory + "'");
   if (test_remote_cache_directory != m_remote_cache_directory)
     throw std::runtime_error("Error in making remote cache directory " + m_remote_cache_directory + " on remote host " +
                              m_backend.host);
   m_remote_cache_directory_verified = true;
+  capabilities.set(m_backend.host, "directory " + m_remote_cache_directory, "verified");
 }
 
 std::tuple<bool, std::string, std::string> sjef::util::Job::pull_rundir(int verbosity) {
   m_trace(3 - verbosity) << "pull_rundir " << verbosity << std::endl;
   if (localhost())
     return {true, "", ""};
+  auto lock = m_project.m_sync_locker->bolt();
   setup_rsync_path();
   std::string command = "rsync --archive --copy-links --timeout=5 -s -v";
   command += " --rsync-path=" + m_remote_rsync;
   command += " --exclude=backup --exclude=*.d";
-  command += " --exclude=Info.plist --exclude=.Info.plist.writing_object";
+  command += " --exclude=Info.plist --exclude=.Info.plist.state --exclude=.Info.plist.journal";
+  command += " --exclude=.Info.plist.new --exclude=*.lock";
   command += " " + system_specific_ssh_options();
   command += " " + m_backend.host + ":'" + m_remote_cache_directory + "/'";
 #ifdef WIN32
@@ -186,19 +323,55 @@ std::tuple<bool, std::string, std::string> sjef::util::Job::pull_rundir(int verb
         << std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start_time).count()
         << "ms" << std::endl
         << "Output from rsync\n:" << rsync_out << std::endl;
-  return {shell.err().find("rsync error:") == std::string::npos, shell.out(),
-          shell.err()}; // TODO: implement more robust error checking
+  // TODO: implement more robust error checking
+  const bool success = shell.err().find("rsync error:") == std::string::npos;
+  if (success)
+    m_project.m_shared_state->set_last_sync_time(std::chrono::system_clock::now());
+  return {success, shell.out(), shell.err()};
 }
 
 sjef::util::Job::~Job() {
   //  if (m_status==sjef::status::completed || m_status==sjef::status::killed) {
   //    end_job();
   //  }
+  stop_polling();
+  leave_status_batch();
+}
+
+void Job::start_polling() {
+  m_poll_finished = false;
+  m_poll_interval = {};
+  m_poll_task = JobMonitor::instance().add([this]() -> std::optional<JobMonitor::clock::duration> {
+    // a failed cycle is tried again, rather than leave the job recorded as running for ever
+    try {
+      return this->poll_job();
+    } catch (const std::exception& e) {
+      m_trace(2) << "Polling cycle failed, and is tried again later: " << e.what() << std::endl;
+    } catch (...) {
+      m_trace(2) << "Polling cycle failed, and is tried again later" << std::endl;
+    }
+    return m_poll_interval_max;
+  });
+  if (m_local_process_status and m_job_number > 0)
+    JobMonitor::instance().wake_on_exit(m_poll_task, m_job_number);
+}
+
+void Job::stop_polling() {
   {
     std::lock_guard lock(m_closing_mutex);
     m_closing = true;
   }
-  m_poll_task.wait();
+  if (m_poll_task != 0) {
+    leave_local_queue(m_poll_task);
+    JobMonitor::instance().remove(m_poll_task);
+  }
+  m_poll_task = 0;
+  if (!m_poll_finished) {
+    try {
+      poll_job(); // closing, so this is the last cycle
+    } catch (...) {
+    }
+  }
 }
 
 inline std::string slurp(const std::filesystem::path& path) {
@@ -208,79 +381,429 @@ inline std::string slurp(const std::filesystem::path& path) {
   return buf.str();
 }
 
-std::string Job::run(const std::string& command, int verbosity, bool wait) {
-  m_closing = true;
-  m_poll_task.wait();
-  m_closing = false;
+void Job::begin_submission() {
+  stop_polling();
+  {
+    std::lock_guard lock(m_closing_mutex);
+    m_closing = false;
+  }
   m_backend_command_server.reset(new Shell(m_backend.host));
+  m_submission_latencies.clear();
+  m_stage_start = JobMonitor::clock::now();
+  auto l = std::lock_guard(m_poll_mutex);
+  m_initial_status = waiting;
+  m_job_number = 0; // pauses status polling
+  m_placement.reset();
+  set_status(waiting);
+}
+
+void Job::stage_done(const std::string& stage) {
+  const auto now = JobMonitor::clock::now();
+  m_submission_latencies.emplace_back(stage, now - m_stage_start);
+  m_stage_start = now;
+}
+
+std::string Job::submit(const std::string& command, int verbosity, bool wait) {
+  auto l = std::lock_guard(m_poll_mutex);
+  //  const auto& substr = std::regex_replace(command, std::regex{"'"}, "").substr(0, m_backend.run_command.size());
+  m_trace(4 - verbosity) << "Job::run() command=" << command << std::endl;
+  //  m_trace(4 - verbosity) << "Job::run substr=" << substr << " m_backend.run_command=" << m_backend.run_command
+  //                         << std::endl;
+  //  auto is_run_command = substr == m_backend.run_command;
+  m_queued = false;
+  m_holds_slot = false;
+  if (m_local_slots and !wait) {
+    try {
+      m_queued = !LocalSlots::instance().enqueue(slot_key(), local_processes(m_project, m_backend));
+      m_holds_slot = !m_queued;
+    } catch (const std::exception&) { // without the ledger, start at once
+    }
+  }
   std::string run_output;
-  {
-    auto l = std::lock_guard(kill_mutex);
-    //  const auto& substr = std::regex_replace(command, std::regex{"'"}, "").substr(0, m_backend.run_command.size());
-    m_trace(4 - verbosity) << "Job::run() command=" << command << std::endl;
-    //  m_trace(4 - verbosity) << "Job::run substr=" << substr << " m_backend.run_command=" << m_backend.run_command
-    //                         << std::endl;
-    //  auto is_run_command = substr == m_backend.run_command;
-    m_initial_status = waiting;
-    m_job_number = 0; // pauses status polling
-                      //    std::cout << "Job::run() set initial status to waiting, and pause polling"<<std::endl;
-    set_status(waiting);
-    auto backend_submits_batch = m_backend.run_jobnumber != "([0-9]+)";
-    if (!localhost()) {
-      const auto& push_rundir_result = push_rundir(verbosity);
-      if (!std::get<0>(push_rundir_result))
-        throw std::runtime_error("Push of data to remote cache has failed\nOutput:\n" +
-                                 std::get<1>(push_rundir_result) + "\nError:" + std::get<2>(push_rundir_result));
+  if (m_queued) {
+    m_trace(4 - verbosity) << "Job::run() waits for a local slot" << std::endl;
+    m_queued_command = command;
+    stage_done("submit");
+    stage_done("jobnumber");
+  } else
+    run_output = launch(command, verbosity, wait);
+  start_confirmation();
+  if (m_queued) {
+    auto& queue = local_queue();
+    std::lock_guard lock(queue.mutex);
+    queue.tasks.insert(m_poll_task);
+  }
+  return run_output;
+}
+
+std::string Job::launch(const std::string& command, int verbosity, bool wait, bool record_stages) {
+  auto backend_submits_batch = m_backend.run_jobnumber != "([0-9]+)";
+  LocalSlots::placement placement;
+  if (m_holds_slot) {
+    try {
+      placement = LocalSlots::instance().placement_of(slot_key());
+    } catch (const std::exception&) {
+    }
+  }
+  m_backend_command_server->cpus(placement.cpus);
+  if (m_local_slots) // recorded for every local run, so that the throughput of different placements can be compared
+    m_placement = placement.cpus.empty() ? "" : "cpus=" + LocalSlots::cpu_list(placement.cpus) + " numa_node=" +
+                                                    std::to_string(placement.numa_node);
+  m_trace(4 - verbosity) << "Job::run() gives directory " << m_project.filename("", "", 0) << std::endl;
+  m_trace(4 - verbosity) << "before submit, m_backend_command_server? " << (m_backend_command_server == nullptr)
+                         << std::endl;
+  (*m_backend_command_server)(command, wait or backend_submits_batch,
+                              localhost() ? m_project.filename("", "", 0).string() : m_remote_cache_directory,
+                              verbosity, m_project.filename("stdout", "", 0).filename().string(),
+                              m_project.filename("stderr", "", 0).filename().string());
+  if (record_stages)
+    stage_done("submit");
+  pull_rundir(); // the output of a remote submission, from which the job number is taken
+  auto run_output = slurp(m_project.filename("stdout", "", 0)) + "\n" + slurp(m_project.filename("stderr", "", 0));
+  if (backend_submits_batch) {
+    std::smatch match;
+    if (std::regex_search(run_output, match, std::regex{m_backend.run_jobnumber})) {
+      //        m_trace(5 - verbosity) << "... a match was found: " << match[1] << std::endl;
+      m_job_number = std::stoi(match[1]);
+      m_trace(4 - verbosity) << "Job::run backend_submits_batch m_job_number=" << m_job_number << std::endl;
     }
-    push_rundir(verbosity); // do it again to allow time to settle
-    m_trace(4 - verbosity) << "Job::run() gives directory " << m_project.filename("", "", 0) << std::endl;
-    m_trace(4 - verbosity) << "before submit, m_backend_command_server? " << (m_backend_command_server == nullptr)
+  } else {
+    m_trace(4 - verbosity) << "before job_number(), m_backend_command_server? " << (m_backend_command_server == nullptr)
                            << std::endl;
-    (*m_backend_command_server)(command, wait or backend_submits_batch,
-                                localhost() ? m_project.filename("", "", 0).string() : m_remote_cache_directory,
-                                verbosity, m_project.filename("stdout", "", 0).filename().string(),
-                                m_project.filename("stderr", "", 0).filename().string());
-    pull_rundir();
-    run_output = slurp(m_project.filename("stdout", "", 0)) + "\n" + slurp(m_project.filename("stderr", "", 0));
-    if (backend_submits_batch) {
-      std::smatch match;
-      if (std::regex_search(run_output, match, std::regex{m_backend.run_jobnumber})) {
-        //        m_trace(5 - verbosity) << "... a match was found: " << match[1] << std::endl;
-        m_job_number = std::stoi(match[1]);
-        m_trace(4 - verbosity) << "Job::run backend_submits_batch m_job_number=" << m_job_number << std::endl;
+    m_job_number = m_backend_command_server->job_number();
+    m_trace(4 - verbosity) << "Job::run is_run_command m_job_number=" << m_job_number << std::endl;
+  }
+  if (m_holds_slot and m_job_number > 0) {
+    try {
+      LocalSlots::instance().assign(slot_key(), m_job_number); // freed when the job's process ends
+    } catch (const std::exception&) {
+    }
+  }
+  if (record_stages)
+    stage_done("jobnumber");
+  return run_output;
+}
+
+void Job::start_queued(int verbosity, bool wait_for_slot) {
+  using namespace std::literals::chrono_literals;
+  // Nothing else will start the job once this process has stopped polling it, but the wait is bounded, since it is
+  // made by a destructor
+  const char* patience = std::getenv("SJEF_LOCAL_QUEUE_WAIT");
+  const auto deadline = JobMonitor::clock::now() + seconds(patience == nullptr ? "" : patience, 10s);
+  for (auto delay = 10ms;; delay = std::min(delay * 2, std::chrono::milliseconds(1s))) {
+    std::optional<bool> started = true;
+    try {
+      started = LocalSlots::instance().try_start(slot_key());
+      if (started == false and wait_for_slot and JobMonitor::clock::now() >= deadline and
+          LocalSlots::instance().cancel(slot_key())) {
+        m_trace(-verbosity) << "Job in " << slot_key() << " has not started, since no local slot became free"
+                            << std::endl;
+        started.reset();
       }
-    } else {
-      m_trace(4 - verbosity) << "before job_number(), m_backend_command_server? "
-                             << (m_backend_command_server == nullptr) << std::endl;
-      m_job_number = m_backend_command_server->job_number();
-      m_trace(4 - verbosity) << "Job::run is_run_command m_job_number=" << m_job_number << std::endl;
+    } catch (const std::exception&) { // without the ledger, start at once
     }
-    m_poll_task = std::async(std::launch::async, [this]() { this->poll_job(); });
+    if (!started) { // cancelled by kill() in another process, or given up
+      m_queued = false;
+      m_killed = true;
+      leave_local_queue(m_poll_task);
+      return;
+    }
+    if (*started)
+      break;
+    if (!wait_for_slot)
+      return;
+    std::this_thread::sleep_for(std::min<JobMonitor::clock::duration>(delay, deadline - JobMonitor::clock::now()));
+  }
+  m_trace(4 - verbosity) << "Job::start_queued() has a local slot" << std::endl;
+  m_queued = false;
+  m_holds_slot = true;
+  leave_local_queue(m_poll_task);
+  launch(m_queued_command, verbosity, false, false);
+  const_cast<Project&>(m_project).property_set(
+      {{"jobnumber", std::to_string(m_job_number)}, {"placement", m_placement.value_or("")}});
+  if (m_local_process_status and m_job_number > 0)
+    JobMonitor::instance().wake_on_exit(m_poll_task, m_job_number);
+}
+
+void Job::start_confirmation() {
+  {
+    std::lock_guard lock(m_confirmation_mutex);
+    m_confirmed = false;
   }
-  // give the poll task time to get a first result
-  //  std::cout << "status immediately after launching poll_task "<<m_project.status_message()<<" id
-  //  "<<std::this_thread::get_id()<<std::endl;
-  for (int i = 0; i < 20 && m_project.status() == sjef::status::waiting; ++i) {
+  start_polling(); // the first cycle is due at once
+}
+
+void Job::await_confirmation() {
+  // return once polling has found the job, or found that it has already finished; the limit only guards against a
+  // status command that never finds the job
+  {
     using namespace std::literals::chrono_literals;
-    std::this_thread::sleep_for(50ms);
-    //  std::cout << "status after waiting "<<m_project.status_message()<<std::endl;
+    std::unique_lock lock(m_confirmation_mutex);
+    m_confirmation.wait_for(lock, 1s, [this]() { return m_confirmed; });
+  }
+  stage_done("confirm");
+}
+
+std::string Job::run(const std::string& command, int verbosity, bool wait) {
+  begin_submission();
+  if (!localhost()) { // rsync has finished, and reported success, before the job is submitted
+    const auto& push_rundir_result = push_rundir(verbosity);
+    if (!std::get<0>(push_rundir_result))
+      throw std::runtime_error("Push of data to remote cache has failed\nOutput:\n" + std::get<1>(push_rundir_result) +
+                               "\nError:" + std::get<2>(push_rundir_result));
+  }
+  stage_done("push");
+  std::string run_output;
+  try {
+    run_output = submit(command, verbosity, wait);
+  } catch (...) {
+    abandon_submission();
+    throw;
   }
+  await_confirmation();
   m_trace(2 - verbosity) << "Job::run() returns " << run_output << std::endl;
   return run_output;
 }
 
+void Job::push_many(const std::vector<Job*>& jobs, int verbosity) {
+  if (jobs.empty() or jobs.front()->localhost())
+    return;
+#ifdef WIN32
+  // rsync there cannot follow the links used below, so push each run directory separately
+  for (const auto& j : jobs)
+    if (const auto& result = j->push_rundir(verbosity); !std::get<0>(result))
+      throw sync_error(("Push of data to remote cache has failed\nError:" + std::get<2>(result)).c_str());
+  return;
+#endif
+  const auto& job = *jobs.front();
+  // a directory of links named as the remote cache directories, so that one rsync can copy every run directory
+  const auto links = fs::temp_directory_path() /
+                     ("sjef-push-" + std::to_string(std::hash<std::string>{}(job.m_remote_cache_directory)) + "-" +
+                      std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()));
+  fs::create_directories(links);
+  std::list<Locker::Bolt> bolts;
+  auto sorted = jobs;
+  std::sort(sorted.begin(), sorted.end(), [](const Job* a, const Job* b) {
+    return a->m_project.filename() < b->m_project.filename(); // a consistent order for taking the locks
+  });
+  for (const auto& j : sorted) {
+    const auto cache = j->m_remote_cache_directory;
+    fs::create_directory_symlink(j->m_project.filename("", "", 0), links / cache.substr(cache.rfind('/') + 1));
+    bolts.emplace_back(*j->m_project.m_sync_locker);
+  }
+  setup_rsync_path();
+  std::string command = "rsync --archive --copy-links --timeout=5 -s -v";
+  command += " --rsync-path=" + job.m_remote_rsync;
+  command += " --exclude=Info.plist --exclude=.Info.plist.state --exclude=.Info.plist.journal";
+  command += " --exclude=.Info.plist.new --exclude=*.lock";
+  command += " " + system_specific_ssh_options();
+  command += " '" + links.string() + "/'";
+  command += " " + job.m_backend.host + ":'" + job.m_backend.cache + "'";
+  job.m_project.m_trace(2 - verbosity) << "Push rsync: " << command << std::endl;
+  (*job.m_backend_command_server)("mkdir -p '" + job.m_backend.cache + "'");
+  const Shell& shell = Shell("localhost", "");
+  std::string error;
+  try {
+    shell(command, true, ".", verbosity);
+    if (shell.err().find("rsync error:") != std::string::npos)
+      error = shell.err();
+  } catch (const sjef::util::Shell::runtime_error& e) {
+    error = e.what();
+  }
+  fs::remove_all(links);
+  if (!error.empty()) {
+    HostCapabilities::instance().forget(job.m_backend.host);
+    throw sync_error(("Push of data to remote cache has failed\nError:" + error).c_str());
+  }
+  for (const auto& j : jobs) {
+    j->m_remote_cache_directory_verified = true;
+    j->m_project.m_shared_state->set_last_sync_time(std::chrono::system_clock::now());
+  }
+}
+
+void Job::run_many(const std::vector<std::pair<Job*, std::string>>& jobs, int verbosity,
+                   const std::string& array_command, const std::vector<std::string>& inputs) {
+  std::vector<Job*> submitted;
+  for (const auto& [job, command] : jobs) {
+    job->begin_submission();
+    submitted.push_back(job);
+  }
+  try {
+    submit_together(jobs, verbosity, array_command, inputs);
+  } catch (...) {
+    for (const auto& job : submitted)
+      if (job->m_poll_task == 0) // otherwise it was submitted, and is being polled
+        job->abandon_submission();
+    throw;
+  }
+  for (const auto& job : submitted)
+    job->await_confirmation();
+}
+
+void Job::abandon_submission() {
+  // begin_submission() left the job waiting, where nothing would poll it, and run_prepare() would not submit it again
+  if (m_holds_slot) {
+    m_holds_slot = false;
+    try {
+      LocalSlots::instance().release(slot_key());
+    } catch (const std::exception&) {
+    }
+    wake_local_queue();
+  }
+  set_status(failed);
+}
+
+void Job::submit_together(const std::vector<std::pair<Job*, std::string>>& jobs, int verbosity,
+                          const std::string& array_command, const std::vector<std::string>& inputs) {
+  std::vector<Job*> submitted;
+  for (const auto& [job, command] : jobs)
+    submitted.push_back(job);
+  push_many(submitted, verbosity);
+  for (const auto& job : submitted)
+    job->stage_done("push");
+  // jobs that launch themselves on this host are each started through the local slots instead
+  const bool array = !array_command.empty() and
+                     std::none_of(submitted.begin(), submitted.end(), [](const Job* job) { return job->m_local_slots; });
+  if (!array) {
+    for (const auto& [job, command] : jobs)
+      job->submit(command, verbosity, false);
+  } else if (!submitted.empty()) {
+    auto& server = *submitted.front()->m_backend_command_server;
+    const auto& backend = submitted.front()->m_backend;
+    auto command = array_command;
+    for (size_t i = 0; i < submitted.size(); ++i) {
+      const auto& job = *submitted[i];
+      if (job.localhost())
+        command += " '" + (job.m_project.filename("", "", 0) / inputs.at(i)).string() + "'";
+      else
+        command += " '" + job.m_remote_cache_directory.substr(job.m_remote_cache_directory.rfind('/') + 1) + "/" +
+                   inputs.at(i) + "'";
+    }
+    submitted.front()->m_trace(4 - verbosity) << "Job::run_many() command=" << command << std::endl;
+    const auto output = server(command, true, submitted.front()->localhost() ? "." : backend.cache, verbosity);
+    std::vector<int> job_numbers;
+    const std::regex jobnumber{backend.run_jobnumber};
+    for (auto match = std::sregex_iterator(output.begin(), output.end(), jobnumber); match != std::sregex_iterator();
+         ++match)
+      job_numbers.push_back(std::stoi((*match)[1]));
+    if (job_numbers.size() != submitted.size())
+      throw std::runtime_error("Submission of " + std::to_string(submitted.size()) + " jobs gave " +
+                               std::to_string(job_numbers.size()) + " job numbers\nOutput:\n" + output +
+                               "\nError:\n" + server.err());
+    for (size_t i = 0; i < submitted.size(); ++i) {
+      auto& job = *submitted[i];
+      job.stage_done("submit");
+      {
+        auto l = std::lock_guard(job.m_poll_mutex);
+        job.m_job_number = job_numbers[i];
+      }
+      job.stage_done("jobnumber");
+      job.start_confirmation();
+    }
+  }
+}
+
 void Job::set_status(status stat) {
-  const_cast<Project&>(m_project).property_set("_status", std::to_string(static_cast<int>(stat)));
+  // status() reads the shared job state, so the property file need only be written when the status changes
+  if (m_project.status() != stat)
+    const_cast<Project&>(m_project).property_set("_status", std::to_string(static_cast<int>(stat)));
+}
+
+std::optional<std::string> Job::batch_status_output(int verbosity, bool wait) {
+  auto& batch = *m_status_batch;
+  std::unique_lock lock(batch.mutex);
+  if (m_status_batch_job_number != m_job_number) {
+    if (m_status_batch_job_number != 0)
+      batch.jobs.erase(batch.jobs.find(m_status_batch_job_number));
+    batch.jobs.insert(m_job_number);
+    m_status_batch_job_number = m_job_number;
+    m_status_batch_query = batch.queries + 1; // a query already started does not include this job
+  }
+  if (batch.querying and !wait) { // rather than hold up a worker, poll again when the query finishes
+    batch.waiting.insert(m_poll_task);
+    return std::nullopt;
+  }
+  batch.query_finished.wait(lock, [&batch]() { return !batch.querying; });
+  if (batch.query_done >= m_status_batch_query) { // another job has queried since this one last looked
+    m_status_batch_query = batch.query_done + 1;
+    return batch.output;
+  }
+  const auto query = ++batch.queries;
+  batch.querying = true;
+  std::string jobs;
+  for (const auto& job : std::set<int>(batch.jobs.begin(), batch.jobs.end()))
+    jobs += (jobs.empty() ? "" : ",") + std::to_string(job);
+  lock.unlock();
+  auto command = m_backend.status_batch_command;
+  if (auto pos = command.find("{jobs}"); pos != std::string::npos)
+    command.replace(pos, 6, jobs);
+  else
+    command += " " + jobs;
+  std::string output;
+  std::exception_ptr failure;
+  try {
+    output = (*m_backend_command_server)(command, true, ".", verbosity);
+  } catch (...) {
+    failure = std::current_exception();
+  }
+  lock.lock();
+  if (!failure) { // otherwise the jobs waiting for this query make their own
+    batch.output = output;
+    batch.query_done = query;
+    m_status_batch_query = query + 1;
+  }
+  batch.querying = false;
+  batch.query_finished.notify_all();
+  auto waiting = std::move(batch.waiting);
+  batch.waiting.clear();
+  lock.unlock();
+  for (const auto& task : waiting)
+    JobMonitor::instance().wake(task);
+  if (failure)
+    std::rethrow_exception(failure);
+  return output;
+}
+
+std::string Job::local_process_status_output() const {
+  // the line that ps -o pid,state would give
+  std::ifstream stat("/proc/" + std::to_string(m_job_number) + "/stat");
+  std::string line;
+  if (!std::getline(stat, line))
+    return "";
+  const auto command_end = line.rfind(')'); // the command name can contain anything
+  if (command_end == std::string::npos or command_end + 2 >= line.size())
+    return "";
+  return std::to_string(m_job_number) + " " + line[command_end + 2];
+}
+
+void Job::leave_status_batch() {
+  if (!m_status_batch)
+    return;
+  std::lock_guard lock(m_status_batch->mutex);
+  if (m_status_batch_job_number != 0)
+    m_status_batch->jobs.erase(m_status_batch->jobs.find(m_status_batch_job_number));
+  m_status_batch_job_number = 0;
+  m_status_batch->waiting.erase(m_poll_task);
 }
 
-status Job::get_status(int verbosity) {
+status Job::get_status(int verbosity) { return *query_status(verbosity, true); }
+
+std::optional<status> Job::query_status(int verbosity, bool wait) {
   if (m_job_number == 0)
     return unknown;
   std::string status_string;
   sjef::status result = unknown;
   try {
-    status_string = (*m_backend_command_server)(m_backend.status_command + " " + std::to_string(m_job_number), true,
-                                                ".", verbosity);
+    if (m_status_batch) {
+      auto output = batch_status_output(verbosity, wait);
+      if (!output)
+        return std::nullopt;
+      status_string = *output;
+    } else if (m_local_process_status)
+      status_string = local_process_status_output();
+    else
+      status_string = (*m_backend_command_server)(m_backend.status_command + " " + std::to_string(m_job_number), true,
+                                                  ".", verbosity);
     //  std::cout << "status_string:\n" << status_string << std::endl;
     std::stringstream ss(status_string);
     for (std::string line; std::getline(ss, line);) {
@@ -297,7 +820,12 @@ status Job::get_status(int verbosity) {
         }
       }
     }
+    m_project.m_shared_state->set_last_poll_time(std::chrono::system_clock::now());
+    m_status_query_failed = false;
   } catch (...) {
+    // A status command also fails when the job has gone, but a single failure might be transient
+    if (!std::exchange(m_status_query_failed, true) and !wait)
+      throw;
   }
   //  std::cout << "running pattern: " << m_backend.status_running << std::endl;
   //  std::cout << Command()("ps -p "+std::to_string(m_job_number)) << std::endl;
@@ -309,6 +837,21 @@ status Job::get_status(int verbosity) {
 }
 void Job::kill(int verbosity) {
   m_trace(4 - verbosity) << "Job::kill()" << std::endl;
+  if (m_local_slots and m_job_number == 0) {
+    auto l = std::lock_guard(m_poll_mutex);
+    bool cancelled = m_queued;
+    try {
+      cancelled = LocalSlots::instance().cancel(slot_key()) or cancelled;
+    } catch (const std::exception&) {
+    }
+    if (cancelled) { // it has not started, so there is nothing to kill
+      m_queued = false;
+      set_status(killed);
+      m_killed = true;
+      return;
+    }
+    m_job_number = std::stoi("0" + m_project.property_get("jobnumber")); // started by another process
+  }
   if (localhost()) {
     // catch failure to kill local jobs
     auto pid = m_project.local_pid_from_output();
@@ -328,7 +871,7 @@ void Job::kill(int verbosity) {
     }
   }
   {
-    auto l = std::lock_guard(kill_mutex);
+    auto l = std::lock_guard(m_poll_mutex);
     //    std::cout << "Job::kill() gets mutex"<<std::endl;
     if (m_backend_command_server != nullptr) {
       auto status_string = (*m_backend_command_server)(m_backend.kill_command + " " + std::to_string(m_job_number),
@@ -337,9 +880,9 @@ void Job::kill(int verbosity) {
     }
     set_status(killed);
     //    std::cout << "Job::kill() finished set_status()"<<std::endl;
+    m_killed = true;
   }
 
-  m_killed = true;
   //  std::cout << "Job::kill() set sentinel"<<std::endl;
 }
 
@@ -348,77 +891,141 @@ std::set<T> vector_to_set(std::vector<T>&& v) {
   auto s = std::set<T>(std::make_move_iterator(v.begin()), std::make_move_iterator(v.end()));
   return s;
 }
-void Job::poll_job(int verbosity) {
-  using Clock = std::chrono::high_resolution_clock;
+std::optional<JobMonitor::clock::duration> Job::poll_job(int verbosity) {
+  using Clock = JobMonitor::clock;
   status status;
   auto start = Clock::now();
   auto stop = Clock::now();
-  //    std::cout << "Polling starts" << std::endl;
-  while (true) {
-    //    std::cout << "m_killed " << m_killed << std::endl;
-    {
-      auto l = std::lock_guard(kill_mutex);
-      //      std::cout << "active polling cycle starts"<<std::endl;
-      //      if (m_killed)
-      //        std::cout << "poll_job received kill sentinel" << std::endl;
-
-      start = Clock::now();
-      status = m_killed ? killed : get_status(verbosity);
-      if (status == running or status == waiting)
-        m_seen_running = true;
-      if (status == unknown) {
-        if (m_initial_status == killed) {
-          status = killed;
-        } else if (m_seen_running or m_initial_status == completed) {
-          // Either this job has actually been observed alive during this Job instance's lifetime and
-          // has now disappeared (the normal way to detect completion on a backend with no batch
-          // scheduler to query), or this instance exists only to check on a job that a previous
-          // invocation already recorded as completed.
-          status = completed;
-        } else if (++m_unconfirmed_polls >= 5) {
-          // We've polled several times since submission without ever catching the job running, and
-          // without any other trustworthy signal either. Most likely it failed and exited before any
-          // status check could see it (e.g. the remote command line itself is rejected immediately --
-          // this is not hypothetical, it happens whenever a backend's run_command has gone stale). Give
-          // up waiting for confirmation rather than polling forever, so that whatever output/error the
-          // job did produce still gets pulled back and reported. This does not reopen the premature-
-          // cleanup bug below: that still requires m_seen_running, so at worst a fast-failing job's
-          // remote cache directory is left behind instead of being cleaned up immediately.
-          status = completed;
-        } else {
-          // Still within the grace period for a freshly submitted job that has not yet been confirmed
-          // running. Report "waiting" rather than the raw "unknown" reading: callers (e.g. pysjef's
-          // Project.wait(), which only loops on "running"/"waiting") treat "unknown" as a terminal,
-          // stop-waiting state, so leaking a merely-transient "unknown" here would make them give up
-          // before this grace period has had a chance to resolve to a real answer. Do NOT infer
-          // completion straight from m_initial_status == waiting -- that value just means a submission
-          // is in progress (see Job::run()), so a single "unknown" read here only means we haven't
-          // caught up with the freshly submitted job yet.
-          status = waiting;
-        }
+  bool finished = false;
+  bool changed = false;
+  //    std::cout << "m_killed " << m_killed << std::endl;
+  {
+    auto l = std::lock_guard(m_poll_mutex);
+    //      std::cout << "active polling cycle starts"<<std::endl;
+    //      if (m_killed)
+    //        std::cout << "poll_job received kill sentinel" << std::endl;
+
+    start = Clock::now();
+    if (m_queued) {
+      std::unique_lock lock(m_closing_mutex);
+      const bool closing = m_closing;
+      lock.unlock();
+      start_queued(verbosity, closing); // a queued job is started before polling closes, rather than lost
+    }
+    if (m_local_slots and m_job_number == 0 and !m_queued and !m_holds_slot)
+      m_job_number = std::stoi("0" + m_project.property_get("jobnumber")); // queued and started by another process
+    // a job waiting for a local slot has no process to ask about
+    const bool queued =
+        m_job_number == 0 and (m_queued or (m_local_slots and LocalSlots::instance().contains(slot_key())));
+    std::optional<sjef::status> found;
+    if (!m_killed and !queued) {
+      // a polling task does not wait for another job's batch query, which wakes it on finishing
+      found = query_status(verbosity, m_poll_task == 0);
+      if (!found)
+        return m_poll_interval_max;
+    }
+    status = m_killed ? killed : queued ? waiting : *found;
+    if (!queued and (status == running or status == waiting))
+      m_seen_running = true;
+    if (status == unknown) {
+      if (m_initial_status == killed) {
+        status = killed;
+      } else if (m_seen_running or m_initial_status == completed) {
+        // Either this job has actually been observed alive during this Job instance's lifetime and
+        // has now disappeared (the normal way to detect completion on a backend with no batch
+        // scheduler to query), or this instance exists only to check on a job that a previous
+        // invocation already recorded as completed.
+        status = completed;
+      } else if (++m_unconfirmed_polls >= 5) {
+        // We've polled several times since submission without ever catching the job running, and
+        // without any other trustworthy signal either. Most likely it failed and exited before any
+        // status check could see it (e.g. the remote command line itself is rejected immediately --
+        // this is not hypothetical, it happens whenever a backend's run_command has gone stale). Give
+        // up waiting for confirmation rather than polling forever, so that whatever output/error the
+        // job did produce still gets pulled back and reported. This does not reopen the premature-
+        // cleanup bug below: that still requires m_seen_running, so at worst a fast-failing job's
+        // remote cache directory is left behind instead of being cleaned up immediately.
+        status = completed;
       } else {
-        m_unconfirmed_polls = 0;
+        // Still within the grace period for a freshly submitted job that has not yet been confirmed
+        // running. Report "waiting" rather than the raw "unknown" reading: callers (e.g. pysjef's
+        // Project.wait(), which only loops on "running"/"waiting") treat "unknown" as a terminal,
+        // stop-waiting state, so leaking a merely-transient "unknown" here would make them give up
+        // before this grace period has had a chance to resolve to a real answer. Do NOT infer
+        // completion straight from m_initial_status == waiting -- that value just means a submission
+        // is in progress (see Job::run()), so a single "unknown" read here only means we haven't
+        // caught up with the freshly submitted job yet.
+        status = waiting;
       }
-      m_trace(4 - verbosity) << "got status " << status << std::endl;
-      pull_rundir(verbosity);
-      set_status(status);
-      //    std::cout << "set status " << m_project.status_message() << std::endl;
-      stop = Clock::now();
-      {
-        std::lock_guard lock(m_closing_mutex);
-        if (m_closing or status == completed or m_killed) {
-          using namespace std::literals::chrono_literals;
-          std::this_thread::sleep_for(10ms);
-          pull_rundir(verbosity);
-          break;
-        }
+    } else {
+      m_unconfirmed_polls = 0;
+    }
+    m_trace(4 - verbosity) << "got status " << status << std::endl;
+    pull_rundir(verbosity);
+    set_status(status);
+    //    std::cout << "set status " << m_project.status_message() << std::endl;
+    if (m_seen_running or queued or status == completed or status == killed) {
+      std::lock_guard lock(m_confirmation_mutex);
+      m_confirmed = true;
+      m_confirmation.notify_all();
+    }
+    changed = output_grown() or status != m_polled_status;
+    m_polled_status = status;
+    stop = Clock::now();
+    {
+      std::lock_guard lock(m_closing_mutex);
+      if (m_closing or status == completed or m_killed) {
+        using namespace std::literals::chrono_literals;
+        std::this_thread::sleep_for(10ms);
+        pull_rundir(verbosity);
+        finished = true;
       }
-      m_trace(4 - verbosity) << "active polling cycle stops" << std::endl;
     }
-    using namespace std::literals::chrono_literals;
-    std::this_thread::sleep_for(10ms);
-    std::this_thread::sleep_for((stop - start) * 2);
+    m_trace(4 - verbosity) << "active polling cycle stops" << std::endl;
+  }
+  const auto interval = next_poll_interval(changed, stop - start);
+  {
+    auto& registry = poll_statistics_by_backend();
+    std::lock_guard lock(registry.mutex);
+    auto& statistics = registry.backends[m_backend.name];
+    ++statistics.polls;
+    if (changed)
+      ++statistics.changes;
+    statistics.busy += stop - start;
+    if (!finished) {
+      statistics.interval += interval;
+      statistics.max_interval = std::max(statistics.max_interval, interval);
+    }
   }
+  if (finished) {
+    finish_polling(status, verbosity);
+    return std::nullopt;
+  }
+  return interval;
+}
+
+bool Job::output_grown() {
+  std::uintmax_t size = 0;
+  for (const auto& file : {m_project.filename("stdout", "", 0), m_project.filename("stderr", "", 0),
+                           m_project.filename("out", "", 0)}) {
+    std::error_code ec;
+    if (const auto file_size = fs::file_size(file, ec); !ec)
+      size += file_size;
+  }
+  const bool grown = size != m_polled_output_size;
+  m_polled_output_size = size;
+  return grown;
+}
+
+JobMonitor::clock::duration Job::next_poll_interval(bool changed, JobMonitor::clock::duration cycle) {
+  using namespace std::literals::chrono_literals;
+  // never poll so often that polling itself becomes the main load
+  const auto shortest = std::max(m_poll_interval_min, 10ms + cycle * 2);
+  m_poll_interval = changed ? shortest : std::max(shortest, std::min(m_poll_interval * 2, m_poll_interval_max));
+  return m_poll_interval;
+}
+
+void Job::finish_polling(status status, int verbosity) {
   // Only perform the remote-cache cleanup (which can delete the remote run directory) when we have
   // genuine confidence in the verdict. "killed" only ever comes from an explicit Job::kill() call (this
   // session) or a status genuinely persisted as killed by a previous one, so it's trustworthy as-is. But
@@ -454,6 +1061,8 @@ void Job::poll_job(int verbosity) {
         auto slash = m_remote_cache_directory.rfind("/");
         (*m_backend_command_server)("cd '" + m_remote_cache_directory.substr(0, slash) + "' && rm -rf '" +
                                     m_remote_cache_directory.substr(slash + 1) + "'");
+        HostCapabilities::instance().forget(m_backend.host, "directory " + m_remote_cache_directory);
+        m_remote_cache_directory_verified = false;
       }
     } else if (remote_manifest.count("No such file") != 0) { // sometimes sync will be tried before the remote cache
                                                              // exists, so stay quiet when that happens
@@ -469,9 +1078,19 @@ void Job::poll_job(int verbosity) {
                           << m_project.filename("", "", 0).string() + "'" << std::endl;
     }
   }
+  leave_status_batch();
+  if (m_holds_slot and (status == completed or status == killed)) { // otherwise it is freed when the process ends
+    m_holds_slot = false;
+    try {
+      LocalSlots::instance().release(slot_key());
+    } catch (const std::exception&) {
+    }
+    wake_local_queue();
+  }
   m_project.m_xml_cached = "";
   set_status(m_project.status_from_output());
   m_backend_command_server.reset(); // close down backend server as no longer needed
+  m_poll_finished = true;
   m_trace(4 - verbosity) << "Polling stops" << std::endl;
 }
 
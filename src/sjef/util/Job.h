@@ -2,12 +2,15 @@
 #define SJEF_JOB_SERVER_H
 #include "../sjef-backend.h"
 #include "../sjef.h"
+#include "JobMonitor.h"
 #include "Logger.h"
 #include "Shell.h"
-#include <future>
+#include <condition_variable>
+#include <optional>
 
 namespace sjef::util {
-class Shell; ///< @private
+class Shell;        ///< @private
+struct status_batch; ///< @private
 /*!
  * Class instance manages polling and service of local and remote jobs
  *
@@ -21,6 +24,7 @@ class Shell; ///< @private
  * - regularly rsync-pull the run directory from remote cache
  * - delete the remote cache, after a final pull, if the job status is finished or killed
  *
+ * Polling is done by the process-wide JobMonitor, so that live jobs do not each need a thread.
  * If the polling discovers that the job has finished, it shuts itself down.
  *
  * The property "status" of project is updated
@@ -46,21 +50,71 @@ public:
    * @return
    */
   std::string run(const std::string& command, int verbosity = 0, bool wait = true);
+  /*!
+   * @brief Submit several jobs on the same backend as run() would, but copy all their run directories to a remote
+   * backend in a single transfer
+   * @param jobs Each job, with the command that run() would be given
+   * @param verbosity
+   * @param array_command If not empty, submit all the jobs with this one command instead, with the input file of each
+   * job appended; its output must contain a match of the backend's run_jobnumber for each job, in the same order. It is
+   * not used for jobs that launch themselves on the local host, which are each started through LocalSlots.
+   * @param inputs The name of the input file of each job, within its run directory, for array_command
+   * @throws std::runtime_error if the submission fails, after marking as failed the jobs that were not submitted
+   */
+  static void run_many(const std::vector<std::pair<Job*, std::string>>& jobs, int verbosity = 0,
+                       const std::string& array_command = "", const std::vector<std::string>& inputs = {});
   int job_number() const { return m_job_number;}
+  /*!
+   * @brief Where the last launch of a local job placed it, as recorded in the project property placement, or nothing if
+   * the job is not run through LocalSlots
+   */
+  const std::optional<std::string>& placement() const { return m_placement; }
+  /*!
+   * @brief How long each stage of the last submission by run() took. The stages are push (of the run directory to a
+   * remote cache), submit, jobnumber (including fetching the output of a remote submission) and confirm (until polling
+   * finds the job).
+   */
+  const std::vector<std::pair<std::string, JobMonitor::clock::duration>>& submission_latencies() const {
+    return m_submission_latencies;
+  }
   void kill(int verbosity = 0);
   status get_status(int verbosity = 0);
+  /*!
+   * @brief Polling activity of the jobs on one backend
+   */
+  struct PollStatistics {
+    std::uint64_t polls = 0;                     //!< The number of polling cycles
+    std::uint64_t changes = 0;                   //!< The number of cycles that found a new status or output
+    JobMonitor::clock::duration busy{};          //!< The total time taken by polling cycles
+    JobMonitor::clock::duration interval{};      //!< The total of the intervals scheduled after each cycle
+    JobMonitor::clock::duration max_interval{};  //!< The longest interval scheduled after a cycle
+  };
+  /*!
+   * @brief The polling activity of this process so far
+   * @return Statistics for each backend name
+   */
+  static std::map<std::string, PollStatistics> poll_statistics();
 
 protected:
   const Project& m_project;
   const sjef::Backend& m_backend;
   const std::string
       m_remote_cache_directory; //!< The path on the remote backend that will be synchronized with run directory
+  const JobMonitor::clock::duration m_poll_interval_min; //!< From the backend's poll_interval_min
+  const JobMonitor::clock::duration m_poll_interval_max; //!< From the backend's poll_interval_max
+  JobMonitor::clock::duration m_poll_interval{};         //!< The interval scheduled after the last polling cycle
+  status m_polled_status = unknown;                      //!< The status found by the last polling cycle
+  std::uintmax_t m_polled_output_size = 0;               //!< The size of the output files at the last polling cycle
   mutable bool m_remote_cache_directory_verified = false;
-  std::future<void> m_poll_task;
+  JobMonitor::id_t m_poll_task = 0; //!< The polling task in JobMonitor, or 0 if none
+  bool m_poll_finished = false;      //!< Set once polling has shut down
   mutable std::shared_ptr<Shell> m_backend_command_server;
   int m_job_number=0;
   mutable Logger m_trace;
   bool m_killed = false;
+  //! Serialises a polling cycle with kill() and run() for this job, so that a kill is never overwritten by the status
+  //! from a cycle that started before it. Other jobs poll concurrently.
+  std::mutex m_poll_mutex;
   bool m_closing = false; //!< set to signal that polling should be stopped
   std::mutex m_closing_mutex;
   status m_initial_status;
@@ -73,13 +127,74 @@ protected:
   //! long poll_job() will wait for confirmation before concluding the job must be finished, so that a
   //! fast-failing job (bad command line, immediate crash, ...) is reported rather than polled forever.
   int m_unconfirmed_polls = 0;
+  //! Whether the last status query failed, so that a failure is believed only when it repeats
+  bool m_status_query_failed = false;
+  std::mutex m_confirmation_mutex;
+  std::condition_variable m_confirmation;
+  bool m_confirmed = false; //!< Set once polling has seen the job submitted by run(), or seen it finish
+  std::vector<std::pair<std::string, JobMonitor::clock::duration>> m_submission_latencies;
+  JobMonitor::clock::time_point m_stage_start; //!< When the current stage of submission began
+  void stage_done(const std::string& stage);
+  //! Stop any polling and mark the job as waiting, ready for submission
+  void begin_submission();
+  //! Submit the job, collect its job number, and start polling for it
+  std::string submit(const std::string& command, int verbosity, bool wait);
+  void start_confirmation();
+  //! Wait for polling to find the job submitted, or finished
+  void await_confirmation();
+  //! Copy the run directories of jobs on the same remote backend in one rsync
+  static void push_many(const std::vector<Job*>& jobs, int verbosity);
+  //! The part of run_many() after begin_submission()
+  static void submit_together(const std::vector<std::pair<Job*, std::string>>& jobs, int verbosity,
+                              const std::string& array_command, const std::vector<std::string>& inputs);
+  //! Mark a job whose submission has failed as failed, rather than leave it waiting
+  void abandon_submission();
+  //! Run the submission command, and collect the job number
+  std::string launch(const std::string& command, int verbosity, bool wait, bool record_stages = true);
+  //! Whether a local job waits for a slot in LocalSlots before it starts
+  bool m_local_slots = false;
+  bool m_queued = false;          //!< Set while the job waits for a local slot
+  bool m_holds_slot = false;      //!< Whether this job holds a local slot, to be freed when it finishes
+  std::string m_queued_command;   //!< The command to launch when a slot is free
+  std::optional<std::string> m_placement; //!< Set by launch() for a job run through LocalSlots
+  std::string slot_key() const { return m_project.filename("", "", 0).string(); }
+  //! Launch a queued job if a slot is free, or once one is if wait_for_slot, though not after waiting longer than
+  //! SJEF_LOCAL_QUEUE_WAIT seconds
+  void start_queued(int verbosity, bool wait_for_slot);
+  //! The jobs on the same host whose status is queried together, if the backend has a status_batch_command
+  std::shared_ptr<status_batch> m_status_batch;
+  int m_status_batch_job_number = 0;         //!< The job number that this job has entered in m_status_batch
+  std::uint64_t m_status_batch_query = 0;    //!< The first batch query whose output is new to this job
+  //! The output of a status query for all the jobs in m_status_batch, or nothing if another job's query is in progress
+  //! and not wait, in which case this job's polling task is woken when it finishes
+  std::optional<std::string> batch_status_output(int verbosity, bool wait);
+  //! The status of the job, or nothing if it is not yet known and not wait. If not wait, a failure of the status query
+  //! that follows a successful one is thrown, so that a polling task tries again later rather than taking the job for
+  //! finished.
+  std::optional<status> query_status(int verbosity, bool wait);
+  //! Whether the status of a local job is read directly from the operating system rather than from status_command
+  bool m_local_process_status = false;
+  std::string local_process_status_output() const;
+  void leave_status_batch();
   std::tuple<bool, std::string, std::string> push_rundir(int verbosity = 0);
   std::tuple<bool, std::string, std::string> pull_rundir(int verbosity = 0);
   std::string m_remote_rsync;
   std::string m_remote_rsync_version;
   std::string m_local_rsync_version;
   const bool localhost() const;
-  void poll_job(int verbosity = 0);
+  /*!
+   * @brief One polling cycle. If the job has finished, or polling is closing, shut down polling.
+   * @return The time until the next cycle is due, or nothing if polling has shut down
+   */
+  std::optional<JobMonitor::clock::duration> poll_job(int verbosity = 0);
+  void finish_polling(status stat, int verbosity = 0);
+  //! Whether the job's output files have grown since the last call
+  bool output_grown();
+  //! Back off the polling interval if nothing has changed, or return to polling quickly if it has
+  JobMonitor::clock::duration next_poll_interval(bool changed, JobMonitor::clock::duration cycle);
+  void start_polling();
+  //! Stop any scheduled polling, and finish it here if it has not already shut down
+  void stop_polling();
   void set_status(status stat);
 
 public:
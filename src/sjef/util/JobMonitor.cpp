@@ -0,0 +1,174 @@
+#include "JobMonitor.h"
+#include <cstdlib>
+#include <string>
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace sjef::util {
+
+///> @private
+inline size_t default_job_monitor_threads() {
+  const char* threads = std::getenv("SJEF_JOB_MONITOR_THREADS");
+  try {
+    if (threads != nullptr && std::stoul(threads) > 0)
+      return std::stoul(threads);
+  } catch (const std::exception&) {
+  }
+  return 4;
+}
+
+JobMonitor& JobMonitor::instance() {
+  // never destroyed, since jobs may outlive static destruction
+  static auto* monitor = new JobMonitor(default_job_monitor_threads());
+  return *monitor;
+}
+
+JobMonitor::JobMonitor(size_t threads) : m_threads(threads) {
+  for (size_t i = 0; i < m_threads; ++i)
+    std::thread([this]() { work(); }).detach();
+}
+
+JobMonitor::id_t JobMonitor::add(task_t task, clock::duration delay) {
+  std::lock_guard lock(m_mutex);
+  const auto id = m_next_id++;
+  auto due = m_schedule.emplace(clock::now() + delay, id);
+  m_tasks.emplace(id, entry{std::move(task), due, {}, false});
+  m_schedule_changed.notify_one();
+  return id;
+}
+
+void JobMonitor::remove(id_t id) {
+  std::unique_lock lock(m_mutex);
+  auto it = m_tasks.find(id);
+  if (it == m_tasks.end())
+    return;
+  for (auto watch = m_exit_watches.begin(); watch != m_exit_watches.end();) {
+    if (watch->second == id) {
+#ifdef __linux__
+      ::epoll_ctl(m_exit_poll, EPOLL_CTL_DEL, watch->first, nullptr);
+      ::close(watch->first);
+#endif
+      watch = m_exit_watches.erase(watch);
+    } else
+      ++watch;
+  }
+  if (it->second.due != m_schedule.end()) { // not running
+    m_schedule.erase(it->second.due);
+    m_tasks.erase(it);
+    return;
+  }
+  it->second.removed = true;
+  if (it->second.thread == std::this_thread::get_id())
+    return; // the worker forgets the task when it returns
+  m_task_finished.wait(lock, [this, id]() { return m_tasks.count(id) == 0; });
+}
+
+void JobMonitor::wake(id_t id) {
+  std::lock_guard lock(m_mutex);
+  wake_locked(id);
+}
+
+void JobMonitor::wake_locked(id_t id) {
+  auto it = m_tasks.find(id);
+  if (it == m_tasks.end() or it->second.removed)
+    return;
+  if (it->second.due == m_schedule.end()) { // running, so call it again when it returns
+    it->second.woken = true;
+    return;
+  }
+  m_schedule.erase(it->second.due);
+  it->second.due = m_schedule.emplace(clock::now(), id);
+  m_schedule_changed.notify_one();
+}
+
+bool JobMonitor::wake_on_exit(id_t id, int pid) {
+#if defined(__linux__) && defined(SYS_pidfd_open)
+  std::lock_guard lock(m_mutex);
+  if (m_tasks.count(id) == 0 or pid <= 0)
+    return false;
+  if (m_exit_poll < 0) {
+    m_exit_poll = ::epoll_create1(EPOLL_CLOEXEC);
+    if (m_exit_poll < 0)
+      return false;
+    std::thread([this]() { watch_exits(); }).detach();
+  }
+  const int pidfd = ::syscall(SYS_pidfd_open, pid, 0);
+  if (pidfd < 0) // no such process, or a kernel older than 5.3
+    return false;
+  epoll_event event{};
+  event.events = EPOLLIN;
+  event.data.fd = pidfd;
+  if (::epoll_ctl(m_exit_poll, EPOLL_CTL_ADD, pidfd, &event) != 0) {
+    ::close(pidfd);
+    return false;
+  }
+  m_exit_watches[pidfd] = id;
+  return true;
+#else
+  return false;
+#endif
+}
+
+void JobMonitor::watch_exits() {
+#ifdef __linux__
+  epoll_event events[16];
+  while (true) {
+    const auto count = ::epoll_wait(m_exit_poll, events, 16, -1);
+    std::lock_guard lock(m_mutex);
+    for (int i = 0; i < count; ++i) {
+      const auto pidfd = events[i].data.fd;
+      auto watch = m_exit_watches.find(pidfd);
+      if (watch == m_exit_watches.end())
+        continue; // already removed
+      wake_locked(watch->second);
+      m_exit_watches.erase(watch);
+      ::epoll_ctl(m_exit_poll, EPOLL_CTL_DEL, pidfd, nullptr);
+      ::close(pidfd);
+    }
+  }
+#endif
+}
+
+void JobMonitor::work() {
+  std::unique_lock lock(m_mutex);
+  while (true) {
+    if (m_schedule.empty()) {
+      m_schedule_changed.wait(lock);
+      continue;
+    }
+    if (const auto next = m_schedule.begin()->first; next > clock::now()) {
+      m_schedule_changed.wait_until(lock, next);
+      continue;
+    }
+    const auto id = m_schedule.begin()->second;
+    m_schedule.erase(m_schedule.begin());
+    auto& task = m_tasks.at(id);
+    task.due = m_schedule.end();
+    task.thread = std::this_thread::get_id();
+    auto function = task.task;
+    lock.unlock();
+    std::optional<clock::duration> delay;
+    try {
+      delay = function();
+    } catch (...) { // there is nobody to report to, so the task is dropped, as documented
+    }
+    lock.lock();
+    auto& finished = m_tasks.at(id);
+    finished.thread = std::thread::id{};
+    if (delay && finished.woken)
+      delay = clock::duration::zero();
+    finished.woken = false;
+    if (delay && !finished.removed) {
+      finished.due = m_schedule.emplace(clock::now() + *delay, id);
+      m_schedule_changed.notify_one();
+    } else {
+      m_tasks.erase(id);
+      m_task_finished.notify_all();
+    }
+  }
+}
+
+} // namespace sjef::util
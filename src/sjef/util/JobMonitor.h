@@ -0,0 +1,88 @@
+#ifndef SJEF_LIB_UTIL_JOBMONITOR_H_
+#define SJEF_LIB_UTIL_JOBMONITOR_H_
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+namespace sjef::util {
+/*!
+ * @brief A fixed pool of threads per process that runs the periodic tasks, such as status checks and synchronisation,
+ * of all live jobs.
+ *
+ * Each task is called when it falls due, on whichever worker is free, and returns how long to wait before calling it
+ * again, or nothing if it has finished. A task that throws is not called again, so a task that should survive its own
+ * failures catches them. A task is never called concurrently with itself. The number of workers does not
+ * depend on the number of tasks; it is taken from the environment variable SJEF_JOB_MONITOR_THREADS if it is set, and is
+ * otherwise 4.
+ */
+class JobMonitor {
+public:
+  using clock = std::chrono::steady_clock;
+  using task_t = std::function<std::optional<clock::duration>()>;
+  using id_t = std::uint64_t;
+  /*!
+   * @brief The monitor for this process, whose threads are started when first needed
+   */
+  static JobMonitor& instance();
+  /*!
+   * @brief Schedule a task
+   * @param task
+   * @param delay How long to wait before first calling the task
+   * @return An identifier for remove()
+   */
+  id_t add(task_t task, clock::duration delay = clock::duration::zero());
+  /*!
+   * @brief Stop calling a task. Unless called from the task itself, waits for any call in progress to finish, so that
+   * whatever the task refers to may then be destroyed.
+   * @param id As returned by add()
+   */
+  void remove(id_t id);
+  /*!
+   * @brief Call a task as soon as possible, rather than waiting until it falls due
+   * @param id As returned by add()
+   */
+  void wake(id_t id);
+  /*!
+   * @brief Wake a task when a local process exits. This is done without spawning processes or polling, using a pidfd
+   * on Linux, and is not available on other platforms.
+   * @param id As returned by add()
+   * @param pid
+   * @return Whether the process is being watched
+   */
+  bool wake_on_exit(id_t id, int pid);
+  /*!
+   * @brief The number of worker threads
+   */
+  size_t threads() const { return m_threads; }
+
+private:
+  explicit JobMonitor(size_t threads);
+  ~JobMonitor() = delete; // the monitor lives until the process ends
+  void work();
+  void wake_locked(id_t id);
+  void watch_exits();
+  struct entry {
+    task_t task;
+    std::multimap<clock::time_point, id_t>::iterator due; ///< m_schedule.end() while running
+    std::thread::id thread;                               ///< the worker running the task, if any
+    bool removed = false;
+    bool woken = false; ///< whether to call the task again as soon as it returns
+  };
+  const size_t m_threads;
+  std::mutex m_mutex; ///< protects everything below
+  std::condition_variable m_schedule_changed;
+  std::condition_variable m_task_finished;
+  std::multimap<clock::time_point, id_t> m_schedule;
+  std::map<id_t, entry> m_tasks;
+  id_t m_next_id = 1;
+  int m_exit_poll = -1;               ///< epoll descriptor for process exits, once needed
+  std::map<int, id_t> m_exit_watches; ///< the task to wake when each pidfd becomes readable
+};
+
+} // namespace sjef::util
+#endif // SJEF_LIB_UTIL_JOBMONITOR_H_
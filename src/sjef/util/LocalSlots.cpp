@@ -0,0 +1,306 @@
+#include "LocalSlots.h"
+#include "../sjef.h"
+#include "Locker.h"
+#include "ReplaceFile.h"
+#include "util.h"
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <set>
+#include <sstream>
+#include <thread>
+#if defined(WIN32) || defined(__WIN64)
+#if defined(_M_AMD64) || defined(_M_X64)
+#define _AMD64_
+#elif defined(_M_IX86)
+#define _X86_
+#endif
+#include <handleapi.h>
+#include <processthreadsapi.h>
+#else
+#include <cerrno>
+#include <signal.h>
+#include <unistd.h>
+#endif
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace sjef::util {
+
+///> @private
+inline int this_process() {
+#if defined(WIN32) || defined(__WIN64)
+  return static_cast<int>(GetCurrentProcessId());
+#else
+  return static_cast<int>(::getpid());
+#endif
+}
+
+///> @private
+inline bool process_alive(int pid) {
+  if (pid <= 0)
+    return false;
+#if defined(WIN32) || defined(__WIN64)
+  HANDLE handle = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, pid);
+  if (handle == NULL)
+    return false;
+  DWORD code;
+  const bool alive = GetExitCodeProcess(handle, &code) && code == STILL_ACTIVE;
+  CloseHandle(handle);
+  return alive;
+#else
+  return ::kill(pid, 0) == 0 or errno == EPERM;
+#endif
+}
+
+LocalSlots& LocalSlots::instance() {
+  // one for each configuration directory, which can be changed while running
+  static std::mutex mutex;
+  static auto* slots = new std::map<fs::path, std::unique_ptr<LocalSlots>>;
+  const auto file = sjef_config_directory() / "local-slots";
+  std::lock_guard lock(mutex);
+  auto& result = (*slots)[file];
+  if (!result)
+    result.reset(new LocalSlots(file));
+  return *result;
+}
+
+size_t LocalSlots::capacity() {
+  const char* slots = std::getenv("SJEF_LOCAL_SLOTS");
+  try {
+    if (slots != nullptr && std::stoul(slots) > 0)
+      return std::stoul(slots);
+  } catch (const std::exception&) {
+  }
+  return std::max(1u, std::thread::hardware_concurrency());
+}
+
+///> @private
+inline std::string local_placement() {
+  const char* placement = std::getenv("SJEF_LOCAL_PLACEMENT");
+  return placement == nullptr ? "none" : placement;
+}
+
+///> @private
+inline std::vector<int> allowed_cpus() {
+  std::vector<int> cpus;
+#ifdef __linux__
+  cpu_set_t set;
+  if (::sched_getaffinity(0, sizeof(set), &set) == 0)
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+      if (CPU_ISSET(cpu, &set))
+        cpus.push_back(cpu);
+#endif
+  return cpus;
+}
+
+///> @private
+inline std::map<int, std::vector<int>> numa_nodes() {
+  std::map<int, std::vector<int>> nodes;
+  std::error_code ec;
+  for (const auto& node : fs::directory_iterator("/sys/devices/system/node", ec)) {
+    const auto name = node.path().filename().string();
+    if (name.rfind("node", 0) != 0 or name.size() == 4 or
+        name.find_first_not_of("0123456789", 4) != std::string::npos)
+      continue;
+    std::ifstream stream(node.path() / "cpulist");
+    std::string list;
+    if (std::getline(stream, list))
+      nodes[std::stoi(name.substr(4))] = LocalSlots::cpu_list(list);
+  }
+  return nodes;
+}
+
+std::string LocalSlots::cpu_list(const std::vector<int>& cpus) {
+  std::string result;
+  const auto sorted = std::set<int>(cpus.begin(), cpus.end());
+  for (auto cpu = sorted.begin(); cpu != sorted.end();) {
+    auto last = cpu;
+    while (std::next(last) != sorted.end() and *std::next(last) == *last + 1)
+      ++last;
+    result += (result.empty() ? "" : ",") + std::to_string(*cpu) + (last == cpu ? "" : "-" + std::to_string(*last));
+    cpu = std::next(last);
+  }
+  return result;
+}
+
+std::vector<int> LocalSlots::cpu_list(const std::string& list) {
+  std::vector<int> cpus;
+  std::istringstream ranges(list);
+  for (std::string range; std::getline(ranges, range, ',');) {
+    try {
+      const auto dash = range.find('-');
+      const auto first = std::stoi(range.substr(0, dash));
+      const auto last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+      for (auto cpu = first; cpu <= last; ++cpu)
+        cpus.push_back(cpu);
+    } catch (const std::exception&) {
+    }
+  }
+  return cpus;
+}
+
+LocalSlots::LocalSlots(fs::path file) : m_file(std::move(file)) {}
+
+std::vector<LocalSlots::entry> LocalSlots::read() const {
+  std::vector<entry> entries;
+  std::ifstream stream(m_file);
+  for (std::string line; std::getline(stream, line);) {
+    std::istringstream fields(line);
+    std::string key, pid, state, slots, cpus, node;
+    if (std::getline(fields, key, '\t') && std::getline(fields, pid, '\t') && std::getline(fields, state, '\t') &&
+        std::getline(fields, slots, '\t') && std::getline(fields, cpus, '\t') && std::getline(fields, node)) {
+      try {
+        entries.push_back(
+            {key, std::stoi(pid), state == "running", std::stoul(slots), {cpu_list(cpus), std::stoi(node)}});
+      } catch (const std::exception&) {
+      }
+    }
+  }
+  return entries;
+}
+
+template <typename Change>
+auto LocalSlots::update(Change change) {
+  std::lock_guard lock(m_mutex);
+  fs::create_directories(m_file.parent_path());
+  Locker locker(fs::path{m_file}.concat(".lock"));
+  auto bolt = locker.bolt();
+  auto entries = read();
+  entries.erase(std::remove_if(entries.begin(), entries.end(), [](const entry& e) { return !process_alive(e.pid); }),
+                entries.end());
+  auto result = change(entries);
+  const auto new_file = fs::path{m_file}.concat(".new");
+  {
+    std::ofstream stream(new_file);
+    for (const auto& e : entries)
+      stream << e.key << '\t' << e.pid << '\t' << (e.running ? "running" : "waiting") << '\t' << e.slots << '\t'
+             << cpu_list(e.place.cpus) << '\t' << e.place.numa_node << '\n';
+  }
+  replace_file(new_file, m_file);
+  return result;
+}
+
+std::optional<bool> LocalSlots::start(std::vector<entry>& entries, const std::string& key) {
+  if (std::none_of(entries.begin(), entries.end(), [&key](const entry& e) { return e.key == key; }))
+    return std::nullopt;
+  const auto size = capacity();
+  size_t free = size;
+  for (const auto& e : entries)
+    if (e.running)
+      free -= std::min(free, e.slots);
+  // the slots go to jobs in the order in which they were queued, so that a large job is not overtaken indefinitely
+  for (auto& e : entries) {
+    if (e.key == key and e.running)
+      return true;
+    if (e.running)
+      continue;
+    const auto needed = std::min(e.slots, size);
+    if (needed > free)
+      return false;
+    if (e.key == key) {
+      e.running = true;
+      place(entries, e);
+      return true;
+    }
+    free -= needed;
+  }
+  return false;
+}
+
+void LocalSlots::place(const std::vector<entry>& entries, entry& job) {
+  job.place = {};
+  const auto mode = local_placement();
+  if (mode == "none")
+    return;
+  std::set<int> used;
+  for (const auto& e : entries)
+    if (e.running and &e != &job)
+      used.insert(e.place.cpus.begin(), e.place.cpus.end());
+  std::vector<int> free;
+  for (const auto& cpu : allowed_cpus())
+    if (used.count(cpu) == 0)
+      free.push_back(cpu);
+  if (free.size() < job.slots)
+    return;
+  const auto nodes = numa_nodes();
+  if (mode == "numa") {
+    // the node with the fewest free cores that is big enough, so that larger nodes stay free for larger jobs
+    std::optional<std::pair<int, std::vector<int>>> best;
+    for (const auto& [node, cpus] : nodes) {
+      std::vector<int> node_free;
+      for (const auto& cpu : cpus)
+        if (std::find(free.begin(), free.end(), cpu) != free.end())
+          node_free.push_back(cpu);
+      if (node_free.size() >= job.slots and (!best or node_free.size() < best->second.size()))
+        best = {node, node_free};
+    }
+    if (best)
+      free = best->second;
+  }
+  job.place.cpus.assign(free.begin(), free.begin() + job.slots);
+  for (const auto& [node, cpus] : nodes)
+    if (std::all_of(job.place.cpus.begin(), job.place.cpus.end(),
+                    [&cpus](int cpu) { return std::find(cpus.begin(), cpus.end(), cpu) != cpus.end(); }))
+      job.place.numa_node = node;
+}
+
+bool LocalSlots::enqueue(const std::string& key, size_t slots) {
+  return *update([&key, slots](std::vector<entry>& entries) {
+    if (std::none_of(entries.begin(), entries.end(), [&key](const entry& e) { return e.key == key; }))
+      entries.push_back({key, this_process(), false, std::max(slots, size_t(1)), {}});
+    return start(entries, key);
+  });
+}
+
+std::optional<bool> LocalSlots::try_start(const std::string& key) {
+  return update([&key](std::vector<entry>& entries) { return start(entries, key); });
+}
+
+void LocalSlots::assign(const std::string& key, int pid) {
+  update([&](std::vector<entry>& entries) {
+    for (auto& e : entries)
+      if (e.key == key)
+        e.pid = pid;
+    return true;
+  });
+}
+
+void LocalSlots::release(const std::string& key) {
+  update([&key](std::vector<entry>& entries) {
+    entries.erase(std::remove_if(entries.begin(), entries.end(), [&key](const entry& e) { return e.key == key; }),
+                  entries.end());
+    return true;
+  });
+}
+
+bool LocalSlots::cancel(const std::string& key) {
+  return update([&key](std::vector<entry>& entries) {
+    const auto waiting = std::find_if(entries.begin(), entries.end(),
+                                      [&key](const entry& e) { return e.key == key and !e.running; });
+    if (waiting == entries.end())
+      return false;
+    entries.erase(waiting);
+    return true;
+  });
+}
+
+bool LocalSlots::contains(const std::string& key) const {
+  const auto entries = read();
+  return std::any_of(entries.begin(), entries.end(),
+                     [&key](const entry& e) { return e.key == key and process_alive(e.pid); });
+}
+
+LocalSlots::placement LocalSlots::placement_of(const std::string& key) const {
+  for (const auto& e : read())
+    if (e.key == key)
+      return e.place;
+  return {};
+}
+
+} // namespace sjef::util
@@ -0,0 +1,123 @@
+#ifndef SJEF_LIB_UTIL_LOCALSLOTS_H_
+#define SJEF_LIB_UTIL_LOCALSLOTS_H_
+#include <cstddef>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace sjef::util {
+/*!
+ * @brief A ledger of the jobs running, or waiting to run, on this machine, which limits how many local jobs run at
+ * once.
+ *
+ * The ledger is the file local-slots in the sjef configuration directory, so the limit applies across all processes.
+ * Each entry is keyed by the run directory of a job, and belongs to a process: the one that queued the job until it
+ * starts, and the job itself thereafter, so that entries left by processes that have ended are discarded. Waiting jobs
+ * start in the order in which they were queued. The number of slots is given by the environment variable
+ * SJEF_LOCAL_SLOTS, and is otherwise the hardware concurrency.
+ *
+ * On Linux, a job that starts can also be given a set of cores, one for each slot, that no other running job has, so
+ * that jobs do not migrate onto each other's cores. The environment variable SJEF_LOCAL_PLACEMENT chooses how: "none",
+ * the default, leaves jobs unbound; "cores" takes the lowest free cores; and "numa" keeps each job within one NUMA node
+ * if one has enough free cores, so that its memory is allocated there. Binding suits jobs that run one thread for each
+ * slot, since a job's threads are confined to its cores. A job is also unbound if there are not enough free cores for
+ * it, which happens when there are more slots than cores.
+ */
+class LocalSlots {
+public:
+  /*!
+   * @brief The ledger in the current sjef configuration directory
+   */
+  static LocalSlots& instance();
+  /*!
+   * @brief The number of jobs that may run at once
+   */
+  static size_t capacity();
+  /*!
+   * @brief Queue a job, and take slots for it if enough are free and no job queued earlier is waiting
+   * @param key
+   * @param slots The number of slots that the job needs, for example one for each of its processes
+   * @return Whether the job may start now
+   */
+  bool enqueue(const std::string& key, size_t slots = 1);
+  /*!
+   * @brief Take slots for a queued job if enough are free and no job queued earlier is waiting
+   * @param key
+   * @return Whether the job may start now, or nothing if it is no longer queued, for example because it has been
+   * cancelled
+   */
+  std::optional<bool> try_start(const std::string& key);
+  /*!
+   * @brief Hand the slot of a job that has started to the job's process, so that it is freed when the process ends
+   * @param key
+   * @param pid
+   */
+  void assign(const std::string& key, int pid);
+  /*!
+   * @brief Free the slot of a job, or remove it from the queue
+   * @param key
+   */
+  void release(const std::string& key);
+  /*!
+   * @brief Remove a job from the queue if it has not started
+   * @param key
+   * @return Whether the job was waiting
+   */
+  bool cancel(const std::string& key);
+  /*!
+   * @brief Whether the ledger has an entry for a job, either waiting or running
+   * @param key
+   */
+  bool contains(const std::string& key) const;
+  /*!
+   * @brief Where a running job has been placed
+   */
+  struct placement {
+    std::vector<int> cpus; ///< The cores, or none if the job is not bound to any
+    int numa_node = -1;    ///< The NUMA node that holds all the cores, if there is one
+  };
+  /*!
+   * @brief Where a job has been placed
+   * @param key
+   */
+  placement placement_of(const std::string& key) const;
+  /*!
+   * @brief A set of cores in the form used by Linux, for example 0-3,8
+   * @param cpus
+   */
+  static std::string cpu_list(const std::vector<int>& cpus);
+  /*!
+   * @brief Parse a set of cores in the form used by Linux
+   * @param list
+   */
+  static std::vector<int> cpu_list(const std::string& list);
+  /*!
+   * @brief The file in which the ledger is kept
+   */
+  const std::filesystem::path& file() const { return m_file; }
+
+private:
+  explicit LocalSlots(std::filesystem::path file);
+  struct entry {
+    std::string key;
+    int pid;
+    bool running;
+    size_t slots = 1;
+    placement place;
+  };
+  std::vector<entry> read() const;
+  //! Read the ledger, discarding entries whose process has ended, apply a change, and write it back
+  template <typename Change>
+  auto update(Change change);
+  //! Grant slots to the job if it is due them
+  static std::optional<bool> start(std::vector<entry>& entries, const std::string& key);
+  //! Choose cores for a job that is starting
+  static void place(const std::vector<entry>& entries, entry& job);
+  const std::filesystem::path m_file;
+  mutable std::mutex m_mutex; ///< serialises updates within this process
+};
+
+} // namespace sjef::util
+#endif // SJEF_LIB_UTIL_LOCALSLOTS_H_
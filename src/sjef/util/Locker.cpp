@@ -1,7 +1,12 @@
+#include <algorithm>
+#include <cstdlib>
 #include <fstream>
 #include <iostream>
 #include <map>
 #include <mutex>
+#include <optional>
+#include <set>
+#include <stdexcept>
 #include <string>
 #ifdef _WIN32
 #include <windows.h>
@@ -33,34 +38,342 @@ inline fs::path lock_file(fs::path path) {
   return result;
 }
 
+///> @private
+struct Locker::statistics_record {
+  std::atomic<std::uint64_t> acquisitions{0};
+  std::atomic<std::uint64_t> shared_acquisitions{0};
+  std::atomic<std::uint64_t> total_wait{0};
+  std::atomic<std::uint64_t> max_wait{0};
+  std::array<std::atomic<std::uint64_t>, hold_buckets> hold_histogram{};
+  std::array<std::atomic<std::uint64_t>, hold_buckets> shared_hold_histogram{};
+  std::atomic<std::thread::id> owner;
+  std::atomic<int> shared_holders{0};
+
+  void waited(std::chrono::steady_clock::duration wait) {
+    const std::uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(wait).count();
+    total_wait.fetch_add(ns, std::memory_order_relaxed);
+    for (auto max = max_wait.load(std::memory_order_relaxed);
+         ns > max && !max_wait.compare_exchange_weak(max, ns, std::memory_order_relaxed);)
+      ;
+  }
+  static void held(std::array<std::atomic<std::uint64_t>, hold_buckets>& histogram,
+                   std::chrono::steady_clock::duration hold) {
+    size_t bucket = 0;
+    for (auto us = std::chrono::duration_cast<std::chrono::microseconds>(hold).count(); us > 0 && bucket + 1 < hold_buckets;
+         us >>= 1)
+      ++bucket;
+    histogram[bucket].fetch_add(1, std::memory_order_relaxed);
+  }
+};
+
+///> @private
+// Never destroyed, since Locker objects may outlive static destruction
+inline std::map<std::string, std::weak_ptr<Locker::statistics_record>>& statistics_registry(
+    std::unique_lock<std::mutex>& lock) {
+  static auto* mutex = new std::mutex;
+  static auto* registry = new std::map<std::string, std::weak_ptr<Locker::statistics_record>>;
+  lock = std::unique_lock(*mutex);
+  return *registry;
+}
+
+inline std::shared_ptr<Locker::statistics_record> statistics_record_for(const fs::path& path) {
+  static size_t pruned_size = 0;
+  std::unique_lock<std::mutex> lock;
+  auto& registry = statistics_registry(lock);
+  auto& entry = registry[fs::absolute(path).string()];
+  auto record = entry.lock();
+  if (!record) {
+    record = std::make_shared<Locker::statistics_record>();
+    entry = record;
+  }
+  if (registry.size() > 2 * pruned_size) { // forget lock files that no longer have a Locker
+    for (auto it = registry.begin(); it != registry.end();)
+      it = it->second.expired() ? registry.erase(it) : std::next(it);
+    pruned_size = registry.size();
+  }
+  return record;
+}
+
+///> @private
+struct Locker::open_file_registry {
+  std::mutex mutex;
+  std::set<Locker*> lockers; // those whose lock file is open
+  size_t limit;
+};
+
+///> @private
+inline size_t default_open_file_limit() {
+  const char* limit = std::getenv("SJEF_LOCK_FILES");
+  try {
+    return limit == nullptr ? 256 : std::stoul(limit);
+  } catch (const std::exception&) {
+    return 256;
+  }
+}
+
+///> @private
+// Never destroyed, since Locker objects may outlive static destruction
+inline Locker::open_file_registry& open_lock_files() {
+  static auto* registry = new Locker::open_file_registry{{}, {}, default_open_file_limit()};
+  return *registry;
+}
+
 Locker::Locker(fs::path path)
-    : m_path(lock_file(std::move(path))),
-      m_file_lock(std::make_unique<boost::interprocess::file_lock>(fs::absolute(m_path).string().c_str())) {}
-Locker::~Locker() = default;
+    : m_path(lock_file(std::move(path))), m_statistics(statistics_record_for(m_path)),
+      m_last_used(std::chrono::steady_clock::now()) {}
+Locker::~Locker() {
+  auto& registry = open_lock_files();
+  std::lock_guard lock(registry.mutex);
+  registry.lockers.erase(this);
+}
+
+// Called with m_mutex held exclusively, or shared together with m_shared_mutex
+boost::interprocess::file_lock& Locker::file_lock() {
+  if (!m_file_lock) {
+    if (!fs::exists(m_path) && fs::is_directory(fs::absolute(m_path).parent_path()))
+      std::ofstream(m_path.string()) << "";
+    m_file_lock = std::make_unique<boost::interprocess::file_lock>(fs::absolute(m_path).string().c_str());
+    auto& registry = open_lock_files();
+    std::lock_guard lock(registry.mutex);
+    registry.lockers.insert(this);
+    if (registry.lockers.size() > registry.limit)
+      close_idle_files(registry, this);
+  }
+  return *m_file_lock;
+}
+
+// Called with registry.mutex held
+void Locker::close_idle_files(open_file_registry& registry, const Locker* keep) {
+  std::vector<Locker*> candidates;
+  for (auto* locker : registry.lockers)
+    if (locker != keep)
+      candidates.push_back(locker);
+  std::sort(candidates.begin(), candidates.end(),
+            [](const Locker* a, const Locker* b) { return a->m_last_used.load() < b->m_last_used.load(); });
+  for (auto* locker : candidates) {
+    if (registry.lockers.size() <= registry.limit)
+      break;
+    // A Locker whose mutex can be taken has no bolts placed, and cannot acquire any until the file is closed
+    if (locker->m_mutex.try_lock()) {
+      locker->m_file_lock.reset();
+      registry.lockers.erase(locker);
+      locker->m_mutex.unlock();
+    }
+  }
+}
+
+size_t Locker::open_file_limit() {
+  auto& registry = open_lock_files();
+  std::lock_guard lock(registry.mutex);
+  return registry.limit;
+}
+
+void Locker::set_open_file_limit(size_t limit) {
+  auto& registry = open_lock_files();
+  std::lock_guard lock(registry.mutex);
+  registry.limit = limit;
+  if (registry.lockers.size() > registry.limit)
+    close_idle_files(registry, nullptr);
+}
+
+size_t Locker::open_files() {
+  auto& registry = open_lock_files();
+  std::lock_guard lock(registry.mutex);
+  return registry.lockers.size();
+}
+
+///> @private
+struct shared_hold {
+  int depth;
+  std::chrono::steady_clock::time_point acquired;
+};
+///> @private
+// The shared bolts held by the calling thread on each Locker
+inline std::map<const Locker*, shared_hold>& shared_depth() {
+  thread_local std::map<const Locker*, shared_hold> depth;
+  return depth;
+}
 
-void Locker::add_bolt() {
+///> @private
+// boost::interprocess::file_lock has no portable timed locking, so it is polled with increasing pauses
+inline bool lock_file_until(boost::interprocess::file_lock& lock, bool sharable,
+                            std::optional<std::chrono::steady_clock::time_point> deadline) {
+  if (!deadline) {
+    if (sharable)
+      lock.lock_sharable();
+    else
+      lock.lock();
+    return true;
+  }
+  for (std::chrono::steady_clock::duration pause = std::chrono::microseconds(100);;
+       pause = std::min<std::chrono::steady_clock::duration>(2 * pause, std::chrono::milliseconds(10))) {
+    if (sharable ? lock.try_lock_sharable() : lock.try_lock())
+      return true;
+    const auto now = std::chrono::steady_clock::now();
+    if (now >= *deadline)
+      return false;
+    std::this_thread::sleep_for(std::min<std::chrono::steady_clock::duration>(pause, *deadline - now));
+  }
+}
+
+void Locker::add_bolt() { add_bolt(std::nullopt); }
+bool Locker::try_add_bolt(std::chrono::steady_clock::duration timeout) {
+  return add_bolt(std::chrono::steady_clock::now() + timeout);
+}
+bool Locker::add_bolt(std::optional<std::chrono::steady_clock::time_point> deadline) {
   auto this_thread = std::this_thread::get_id();
-  if (m_owning_thread == this_thread && m_bolts > 0) {
+  if (m_owning_thread == this_thread) {
     m_bolts++;
-    return;
+    return true;
+  }
+  if (shared_depth().count(this) > 0)
+    throw std::logic_error("Locker::add_bolt called by a thread holding a shared bolt");
+  const auto start = std::chrono::steady_clock::now();
+  if (!deadline)
+    m_mutex.lock();
+  else if (!m_mutex.try_lock_until(*deadline))
+    return false;
+  try {
+    if (!lock_file_until(file_lock(), false, deadline)) {
+      m_mutex.unlock();
+      return false;
+    }
+  } catch (...) {
+    m_mutex.unlock();
+    throw;
   }
-  m_lock.reset(new std::scoped_lock<std::mutex>(m_mutex));
   m_owning_thread = this_thread;
   m_bolts = 1;
-  m_file_lock->lock();
+  m_acquired = std::chrono::steady_clock::now();
+  m_last_used = m_acquired;
+  m_statistics->owner = this_thread;
+  m_statistics->acquisitions.fetch_add(1, std::memory_order_relaxed);
+  m_statistics->waited(m_acquired - start);
+  return true;
 }
 void Locker::remove_bolt() {
   --m_bolts;
   if (m_bolts < 0)
     throw std::out_of_range("Locker::remove_bolt called too many times");
   if (m_bolts == 0) {
+    statistics_record::held(m_statistics->hold_histogram, std::chrono::steady_clock::now() - m_acquired);
+    m_statistics->owner = std::thread::id{};
     m_file_lock->unlock();
-    m_lock.reset(nullptr);
+    m_owning_thread = std::thread::id{};
+    m_mutex.unlock();
+  }
+}
+
+void Locker::add_shared_bolt() { add_shared_bolt(std::nullopt); }
+bool Locker::try_add_shared_bolt(std::chrono::steady_clock::duration timeout) {
+  return add_shared_bolt(std::chrono::steady_clock::now() + timeout);
+}
+bool Locker::add_shared_bolt(std::optional<std::chrono::steady_clock::time_point> deadline) {
+  if (m_owning_thread == std::this_thread::get_id()) {
+    m_bolts++;
+    return true;
+  }
+  auto& depth = shared_depth();
+  if (auto it = depth.find(this); it != depth.end()) {
+    it->second.depth++;
+    return true;
+  }
+  const auto start = std::chrono::steady_clock::now();
+  if (!deadline)
+    m_mutex.lock_shared();
+  else if (!m_mutex.try_lock_shared_until(*deadline))
+    return false;
+  try {
+    // The file lock belongs to the process, so it is taken by the first reader thread and released by the last
+    std::lock_guard lock(m_shared_mutex);
+    if (m_shared_holders == 0 && !lock_file_until(file_lock(), true, deadline)) {
+      m_mutex.unlock_shared();
+      return false;
+    }
+    m_shared_holders++;
+  } catch (...) {
+    m_mutex.unlock_shared();
+    throw;
   }
+  const auto acquired = std::chrono::steady_clock::now();
+  m_last_used = acquired;
+  depth[this] = {1, acquired};
+  m_statistics->shared_holders++;
+  m_statistics->shared_acquisitions.fetch_add(1, std::memory_order_relaxed);
+  m_statistics->waited(acquired - start);
+  return true;
+}
+void Locker::remove_shared_bolt() {
+  if (m_owning_thread == std::this_thread::get_id()) {
+    remove_bolt();
+    return;
+  }
+  auto& depth = shared_depth();
+  auto it = depth.find(this);
+  if (it == depth.end())
+    throw std::out_of_range("Locker::remove_shared_bolt called too many times");
+  if (--it->second.depth > 0)
+    return;
+  statistics_record::held(m_statistics->shared_hold_histogram, std::chrono::steady_clock::now() - it->second.acquired);
+  m_statistics->shared_holders--;
+  depth.erase(it);
+  {
+    std::lock_guard lock(m_shared_mutex);
+    if (--m_shared_holders == 0)
+      m_file_lock->unlock_sharable();
+  }
+  m_mutex.unlock_shared();
+}
+
+///> @private
+inline Locker::Statistics statistics_from(const fs::path& path, const Locker::statistics_record& record) {
+  Locker::Statistics result;
+  result.path = path;
+  result.acquisitions = record.acquisitions;
+  result.shared_acquisitions = record.shared_acquisitions;
+  result.total_wait = std::chrono::nanoseconds(record.total_wait);
+  result.max_wait = std::chrono::nanoseconds(record.max_wait);
+  for (size_t i = 0; i < Locker::hold_buckets; ++i) {
+    result.hold_histogram[i] = record.hold_histogram[i];
+    result.shared_hold_histogram[i] = record.shared_hold_histogram[i];
+  }
+  result.owner = record.owner;
+  result.shared_holders = record.shared_holders;
+  return result;
+}
+
+Locker::Statistics Locker::statistics() const { return statistics_from(fs::absolute(m_path), *m_statistics); }
+
+std::vector<Locker::Statistics> Locker::all_statistics() {
+  std::unique_lock<std::mutex> lock;
+  std::vector<Statistics> result;
+  for (const auto& [path, entry] : statistics_registry(lock))
+    if (auto record = entry.lock())
+      result.push_back(statistics_from(path, *record));
+  return result;
 }
 
 // RAII
 Locker::Bolt Locker::bolt() { return Bolt(*this); }
-Locker::Bolt::Bolt(Locker& locker) : m_locker(locker) { m_locker.add_bolt(); }
-Locker::Bolt::~Bolt() { m_locker.remove_bolt(); }
+Locker::Bolt Locker::try_bolt() { return Bolt(*this, std::chrono::steady_clock::duration::zero()); }
+Locker::Bolt Locker::bolt_for(std::chrono::steady_clock::duration timeout) { return Bolt(*this, timeout); }
+Locker::Bolt::Bolt(Locker& locker) : m_locker(locker), m_bolted(true) { m_locker.add_bolt(); }
+Locker::Bolt::Bolt(Locker& locker, std::chrono::steady_clock::duration timeout)
+    : m_locker(locker), m_bolted(m_locker.try_add_bolt(timeout)) {}
+Locker::Bolt::~Bolt() {
+  if (m_bolted)
+    m_locker.remove_bolt();
+}
+Locker::SharedBolt Locker::shared_bolt() { return SharedBolt(*this); }
+Locker::SharedBolt Locker::try_shared_bolt() { return SharedBolt(*this, std::chrono::steady_clock::duration::zero()); }
+Locker::SharedBolt Locker::shared_bolt_for(std::chrono::steady_clock::duration timeout) {
+  return SharedBolt(*this, timeout);
+}
+Locker::SharedBolt::SharedBolt(Locker& locker) : m_locker(locker), m_bolted(true) { m_locker.add_shared_bolt(); }
+Locker::SharedBolt::SharedBolt(Locker& locker, std::chrono::steady_clock::duration timeout)
+    : m_locker(locker), m_bolted(m_locker.try_add_shared_bolt(timeout)) {}
+Locker::SharedBolt::~SharedBolt() {
+  if (m_bolted)
+    m_locker.remove_shared_bolt();
+}
 } // namespace sjef
@@ -1,11 +1,19 @@
 #ifndef SJEF_LIB_LOCKER_H_
 #define SJEF_LIB_LOCKER_H_
 #define BOOST_ALL_NO_LIB
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <filesystem>
 #include <map>
+#include <memory>
 #include <mutex>
+#include <optional>
+#include <shared_mutex>
 #include <string>
 #include <thread>
+#include <vector>
 namespace fs = std::filesystem;
 
 namespace boost::interprocess {
@@ -25,6 +33,23 @@ namespace sjef::util {
  * called multiple times, with only the first instance having a real effect, and the lock being released when the last
  * bolt is removed. It is recommended not to call add_bolt() directly, but to use the RAII pattern provided by the
  * bolt() function.
+ *
+ * Bolts placed with shared_bolt() (or add_shared_bolt()) admit other shared bolts, in this and other processes, and
+ * exclude only exclusive bolts. They are intended for operations that read, but do not change, the protected resource.
+ * A thread that holds an exclusive bolt may also place shared bolts, which then behave as further exclusive bolts; but a
+ * thread holding only shared bolts may not place an exclusive bolt, since that could deadlock against another reader
+ * doing the same.
+ *
+ * Each Locker records contention statistics, which are gathered, for all Locker objects in the process on the same lock
+ * file, in a process-wide registry that can be read with statistics() and all_statistics(). Only the outermost bolt
+ * held by a thread is timed, at the cost of a few clock readings.
+ *
+ * The lock file is opened when the first bolt is placed. To bound the number of file descriptors used by a process
+ * that handles many lock files, when more than open_file_limit() lock files are open, those of the least recently used
+ * Locker objects that have no bolts placed are closed, to be reopened when next needed.
+ *
+ * Callers that must not wait indefinitely can use try_bolt() and bolt_for(), or their shared counterparts, which give
+ * up if the lock cannot be obtained in time; the resulting bolt then converts to false, and has no effect.
  */
 class Locker {
 public:
@@ -34,28 +59,116 @@ public:
 
   void add_bolt();
   void remove_bolt();
+  void add_shared_bolt();
+  void remove_shared_bolt();
+  /*!
+   * @brief Place a bolt, waiting no longer than a given time for it
+   * @param timeout
+   * @return Whether the bolt was placed; if not, remove_bolt() must not be called
+   */
+  bool try_add_bolt(std::chrono::steady_clock::duration timeout = std::chrono::steady_clock::duration::zero());
+  /*!
+   * @brief Place a shared bolt, waiting no longer than a given time for it
+   * @param timeout
+   * @return Whether the bolt was placed; if not, remove_shared_bolt() must not be called
+   */
+  bool try_add_shared_bolt(std::chrono::steady_clock::duration timeout = std::chrono::steady_clock::duration::zero());
+
+  static constexpr size_t hold_buckets = 24;
+  /*!
+   * @brief Contention statistics for a lock file, accumulated over all Locker objects for it in this process.
+   *
+   * Element 0 of a hold-time histogram counts bolts held for less than a microsecond, and element i those held for at
+   * least 2^(i-1) microseconds and, except for the last element, less than 2^i microseconds.
+   */
+  struct Statistics {
+    fs::path path;
+    std::uint64_t acquisitions = 0;        ///< Exclusive bolts placed, not counting those nested inside others
+    std::uint64_t shared_acquisitions = 0; ///< Shared bolts placed, not counting those nested inside others
+    std::chrono::nanoseconds total_wait{0};
+    std::chrono::nanoseconds max_wait{0};
+    std::array<std::uint64_t, hold_buckets> hold_histogram{};
+    std::array<std::uint64_t, hold_buckets> shared_hold_histogram{};
+    std::thread::id owner; ///< The thread holding an exclusive bolt, if there is one
+    int shared_holders = 0; ///< The number of threads holding a shared bolt
+  };
+  /*!
+   * @brief The contention statistics for this Locker's lock file
+   */
+  Statistics statistics() const;
+  /*!
+   * @brief The contention statistics for every lock file that has a Locker in this process
+   */
+  static std::vector<Statistics> all_statistics();
+
+  /*!
+   * @brief The maximum number of lock files that are kept open while they have no bolts placed. The initial value is
+   * taken from the environment variable SJEF_LOCK_FILES if it is set, otherwise 256.
+   */
+  static size_t open_file_limit();
+  /*!
+   * @brief Change the maximum number of lock files that are kept open, closing idle ones if there are now too many
+   * @param limit
+   */
+  static void set_open_file_limit(size_t limit);
+  /*!
+   * @brief The number of lock files currently open in this process
+   */
+  static size_t open_files();
+
+  struct statistics_record; ///< @private
+  struct open_file_registry; ///< @private
 
 private:
   const fs::path m_path;
-  std::unique_ptr<std::scoped_lock<std::mutex>> m_lock;
-  std::mutex m_mutex;
+  const std::shared_ptr<statistics_record> m_statistics;
+  std::chrono::steady_clock::time_point m_acquired;
+  std::atomic<std::chrono::steady_clock::time_point> m_last_used;
+  std::shared_timed_mutex m_mutex;
   int m_bolts = 0;
-  const std::unique_ptr<boost::interprocess::file_lock> m_file_lock;
-  std::thread::id m_owning_thread;
+  std::mutex m_shared_mutex;
+  int m_shared_holders = 0; // threads in this process holding a shared bolt, and therefore the sharable file lock
+  std::unique_ptr<boost::interprocess::file_lock> m_file_lock; // guarded by m_mutex, or m_shared_mutex for readers
+  std::atomic<std::thread::id> m_owning_thread;
+  boost::interprocess::file_lock& file_lock();
+  static void close_idle_files(open_file_registry& registry, const Locker* keep);
+  bool add_bolt(std::optional<std::chrono::steady_clock::time_point> deadline);
+  bool add_shared_bolt(std::optional<std::chrono::steady_clock::time_point> deadline);
 
 public:
   // RAII
   struct Bolt {
     explicit Bolt(Locker& locker);
+    Bolt(Locker& locker, std::chrono::steady_clock::duration timeout);
     ~Bolt();
     Bolt() = delete;
     Bolt(const Bolt&) = delete;
     Bolt& operator=(const Bolt&) = delete;
+    explicit operator bool() const { return m_bolted; }
 
   private:
     Locker& m_locker;
+    const bool m_bolted;
   };
   Bolt bolt();
+  Bolt try_bolt();
+  Bolt bolt_for(std::chrono::steady_clock::duration timeout);
+  struct SharedBolt {
+    explicit SharedBolt(Locker& locker);
+    SharedBolt(Locker& locker, std::chrono::steady_clock::duration timeout);
+    ~SharedBolt();
+    SharedBolt() = delete;
+    SharedBolt(const SharedBolt&) = delete;
+    SharedBolt& operator=(const SharedBolt&) = delete;
+    explicit operator bool() const { return m_bolted; }
+
+  private:
+    Locker& m_locker;
+    const bool m_bolted;
+  };
+  SharedBolt shared_bolt();
+  SharedBolt try_shared_bolt();
+  SharedBolt shared_bolt_for(std::chrono::steady_clock::duration timeout);
 };
 
 } // namespace sjef::util
@@ -0,0 +1,113 @@
+#include "PropertyJournal.h"
+#include "PropertyStore.h"
+#include <cctype>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace sjef::util {
+
+std::string PropertyJournal::set_record(const std::string& key, const std::string& value) {
+  return "+" + std::to_string(key.size()) + "," + std::to_string(value.size()) + ":" + key + value + "\n";
+}
+
+std::string PropertyJournal::erase_record(const std::string& key) {
+  return "-" + std::to_string(key.size()) + ":" + key + "\n";
+}
+
+std::string PropertyJournal::list_record(const std::string& key, const std::vector<std::string>& values) {
+  auto result = "[" + std::to_string(key.size()) + ":" + key + "\n";
+  for (const auto& value : values)
+    result += list_append_record(key, value);
+  return result;
+}
+
+std::string PropertyJournal::list_append_record(const std::string& key, const std::string& value) {
+  return ">" + std::to_string(key.size()) + "," + std::to_string(value.size()) + ":" + key + value + "\n";
+}
+
+std::string PropertyJournal::list_erase_record(const std::string& key, size_t index) {
+  return "/" + std::to_string(key.size()) + "," + std::to_string(index) + ":" + key + "\n";
+}
+
+size_t PropertyJournal::append(const std::string& records) const {
+  std::ofstream stream(m_path, std::ios_base::app | std::ios_base::binary);
+  stream.write(records.data(), records.size());
+  stream.flush();
+  if (!stream)
+    throw std::runtime_error("Cannot append to property journal " + m_path.string());
+  return size();
+}
+
+size_t PropertyJournal::size() const {
+  std::error_code ec;
+  auto result = std::filesystem::file_size(m_path, ec);
+  return ec ? 0 : result;
+}
+
+void PropertyJournal::clear() const {
+  std::error_code ec;
+  std::filesystem::resize_file(m_path, 0, ec);
+}
+
+///> @private
+inline bool read_number(const std::string& buffer, size_t& pos, char terminator, size_t& number) {
+  number = 0;
+  auto start = pos;
+  for (; pos < buffer.size() && std::isdigit(static_cast<unsigned char>(buffer[pos])); ++pos)
+    number = number * 10 + (buffer[pos] - '0');
+  if (pos >= buffer.size())
+    return false;
+  if (pos == start || buffer[pos] != terminator)
+    throw std::runtime_error("Corrupt property journal");
+  ++pos;
+  return true;
+}
+
+std::optional<size_t> PropertyJournal::replay(PropertyStore& store, size_t offset) const {
+  std::ifstream stream(m_path, std::ios_base::binary);
+  if (!stream.is_open())
+    return offset == 0 ? std::optional<size_t>{0} : std::nullopt;
+  stream.seekg(0, std::ios_base::end);
+  if (static_cast<size_t>(stream.tellg()) < offset)
+    return std::nullopt;
+  stream.seekg(offset);
+  std::ostringstream contents;
+  contents << stream.rdbuf();
+  const auto buffer = contents.str();
+  size_t complete = 0;
+  for (size_t pos = 0; pos < buffer.size(); complete = pos) {
+    const char op = buffer[pos++];
+    size_t key_length, value_length = 0, index = 0;
+    if (op == '+' || op == '>') {
+      if (!read_number(buffer, pos, ',', key_length) || !read_number(buffer, pos, ':', value_length))
+        break;
+    } else if (op == '/') {
+      if (!read_number(buffer, pos, ',', key_length) || !read_number(buffer, pos, ':', index))
+        break;
+    } else if (op == '-' || op == '[') {
+      if (!read_number(buffer, pos, ':', key_length))
+        break;
+    } else
+      throw std::runtime_error("Corrupt property journal " + m_path.string());
+    if (pos + key_length + value_length >= buffer.size())
+      break;
+    if (buffer[pos + key_length + value_length] != '\n')
+      throw std::runtime_error("Corrupt property journal " + m_path.string());
+    auto key = buffer.substr(pos, key_length);
+    if (op == '+')
+      store.set(key, buffer.substr(pos + key_length, value_length));
+    else if (op == '>')
+      store.list_append(key, buffer.substr(pos + key_length, value_length));
+    else if (op == '/')
+      store.list_erase(key, index);
+    else if (op == '[')
+      store.list_set(key, {});
+    else
+      store.erase(key);
+    pos += key_length + value_length + 1;
+  }
+  return offset + complete;
+}
+
+} // namespace sjef::util
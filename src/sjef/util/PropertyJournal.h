@@ -0,0 +1,60 @@
+#ifndef SJEF_LIB_UTIL_PROPERTYJOURNAL_H_
+#define SJEF_LIB_UTIL_PROPERTYJOURNAL_H_
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace sjef::util {
+class PropertyStore;
+/*!
+ * @brief An append-only log of changes to a PropertyStore, kept beside its property file.
+ *
+ * Records are self-delimiting and length-prefixed, so that a journal can be replayed while another process is appending
+ * to it; replay stops after the last complete record. The forms are
+ * - <tt>+klen,vlen:keyvalue\\n</tt> assignment
+ * - <tt>-klen:key\\n</tt> removal
+ * - <tt>[klen:key\\n</tt> creation of an empty list
+ * - <tt>>klen,vlen:keyvalue\\n</tt> appending to a list
+ * - <tt>/klen,index:key\\n</tt> removal of a list element
+ */
+class PropertyJournal {
+public:
+  explicit PropertyJournal(std::filesystem::path file) : m_path(std::move(file)) {}
+  const std::filesystem::path& path() const { return m_path; }
+
+  static std::string set_record(const std::string& key, const std::string& value);
+  static std::string erase_record(const std::string& key);
+  static std::string list_record(const std::string& key, const std::vector<std::string>& values);
+  static std::string list_append_record(const std::string& key, const std::string& value);
+  static std::string list_erase_record(const std::string& key, size_t index);
+
+  /*!
+   * @brief Append records to the journal
+   * @param records One or more records, as made by set_record() and erase_record()
+   * @return The size of the journal afterwards
+   */
+  size_t append(const std::string& records) const;
+  /*!
+   * @brief Apply the records in the journal to a store
+   * @param store
+   * @param offset The position in the journal at which to start
+   * @return The position following the last complete record, or nothing if the journal is now shorter than offset,
+   * meaning that it has been truncated since offset was obtained
+   */
+  std::optional<size_t> replay(PropertyStore& store, size_t offset = 0) const;
+  /*!
+   * @brief The current size of the journal, which is zero if it does not exist
+   */
+  size_t size() const;
+  /*!
+   * @brief Discard all records
+   */
+  void clear() const;
+
+private:
+  const std::filesystem::path m_path;
+};
+
+} // namespace sjef::util
+#endif // SJEF_LIB_UTIL_PROPERTYJOURNAL_H_
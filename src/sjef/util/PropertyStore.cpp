@@ -0,0 +1,156 @@
+#include "PropertyStore.h"
+
+namespace sjef::util {
+
+PropertyStore::PropertyStore() : m_document(std::make_unique<pugi::xml_document>()) { reindex(); }
+PropertyStore::PropertyStore(const PropertyStore& source) : m_document(std::make_unique<pugi::xml_document>()) {
+  m_document->reset(*source.m_document);
+  reindex();
+}
+PropertyStore::~PropertyStore() = default;
+
+std::string PropertyStore::load(const std::filesystem::path& file) {
+  auto result = m_document->load_file(file.string().c_str());
+  reindex();
+  return result ? "" : result.description();
+}
+
+bool PropertyStore::save(const std::filesystem::path& file) const {
+  return m_document->save_file(file.string().c_str());
+}
+
+void PropertyStore::reindex() {
+  m_sorted.clear();
+  m_index.clear();
+  m_lists.clear();
+  if (!m_document->child("plist"))
+    m_document->append_child("plist");
+  if (!m_document->child("plist").child("dict"))
+    m_document->child("plist").append_child("dict");
+  m_dict = m_document->child("plist").child("dict");
+  std::vector<entry> duplicates;
+  for (auto node = m_dict.child("key"); node; node = node.next_sibling("key")) {
+    auto value = node.next_sibling();
+    const std::string type{value.name()};
+    if (type != "string" && type != "array")
+      continue;
+    if (m_index.count(node.child_value()) > 0 || m_lists.count(node.child_value()) > 0)
+      duplicates.push_back({node, value});
+    else if (type == "string")
+      m_sorted.emplace(m_index.emplace(node.child_value(), entry{node, value}).first->first, value);
+    else {
+      auto& list = m_lists.emplace(node.child_value(), list_entry{node, value, {}}).first->second;
+      for (auto element = value.child("string"); element; element = element.next_sibling("string"))
+        list.elements.push_back(element);
+    }
+  }
+  for (const auto& duplicate : duplicates) {
+    m_dict.remove_child(duplicate.key);
+    m_dict.remove_child(duplicate.value);
+  }
+}
+
+const char* PropertyStore::get(const std::string& key) const {
+  auto it = m_index.find(key);
+  return it == m_index.end() ? nullptr : it->second.value.child_value();
+}
+
+void PropertyStore::set(const std::string& key, const std::string& value) {
+  if (auto it = m_index.find(key); it != m_index.end()) {
+    it->second.value.text() = value.c_str();
+    return;
+  }
+  erase(key);
+  auto keynode = m_dict.append_child("key");
+  keynode.text() = key.c_str();
+  auto stringnode = m_dict.append_child("string");
+  stringnode.text() = value.c_str();
+  m_sorted.emplace(m_index.emplace(key, entry{keynode, stringnode}).first->first, stringnode);
+}
+
+bool PropertyStore::erase(const std::string& key) {
+  if (auto it = m_lists.find(key); it != m_lists.end()) {
+    m_dict.remove_child(it->second.key);
+    m_dict.remove_child(it->second.array);
+    m_lists.erase(it);
+    return true;
+  }
+  auto it = m_index.find(key);
+  if (it == m_index.end())
+    return false;
+  m_dict.remove_child(it->second.key);
+  m_dict.remove_child(it->second.value);
+  m_sorted.erase(it->first);
+  m_index.erase(it);
+  return true;
+}
+
+std::vector<std::string> PropertyStore::names() const {
+  std::vector<std::string> result;
+  result.reserve(m_index.size());
+  for (auto node = m_dict.child("key"); node; node = node.next_sibling("key"))
+    if (m_index.count(node.child_value()) > 0 || m_lists.count(node.child_value()) > 0)
+      result.emplace_back(node.child_value());
+  return result;
+}
+
+std::map<std::string, std::string> PropertyStore::prefixed(const std::string& prefix) const {
+  std::map<std::string, std::string> result;
+  for (auto it = m_sorted.lower_bound(prefix); it != m_sorted.end() && it->first.substr(0, prefix.size()) == prefix;
+       ++it)
+    result.emplace_hint(result.end(), it->first, it->second.child_value());
+  return result;
+}
+
+size_t PropertyStore::list_size(const std::string& key) const {
+  auto it = m_lists.find(key);
+  return it == m_lists.end() ? 0 : it->second.elements.size();
+}
+
+const char* PropertyStore::list_get(const std::string& key, size_t index) const {
+  auto it = m_lists.find(key);
+  if (it == m_lists.end() || index >= it->second.elements.size())
+    return nullptr;
+  return it->second.elements[index].child_value();
+}
+
+std::vector<std::string> PropertyStore::list(const std::string& key) const {
+  std::vector<std::string> result;
+  if (auto it = m_lists.find(key); it != m_lists.end())
+    for (const auto& element : it->second.elements)
+      result.emplace_back(element.child_value());
+  return result;
+}
+
+PropertyStore::list_entry& PropertyStore::new_list(const std::string& key) {
+  erase(key);
+  auto keynode = m_dict.append_child("key");
+  keynode.text() = key.c_str();
+  return m_lists.emplace(key, list_entry{keynode, m_dict.append_child("array"), {}}).first->second;
+}
+
+void PropertyStore::list_set(const std::string& key, const std::vector<std::string>& values) {
+  auto& list = new_list(key);
+  for (const auto& value : values) {
+    list.elements.push_back(list.array.append_child("string"));
+    list.elements.back().text() = value.c_str();
+  }
+}
+
+void PropertyStore::list_append(const std::string& key, const std::string& value) {
+  auto it = m_lists.find(key);
+  auto& list = it == m_lists.end() ? new_list(key) : it->second;
+  list.elements.push_back(list.array.append_child("string"));
+  list.elements.back().text() = value.c_str();
+}
+
+bool PropertyStore::list_erase(const std::string& key, size_t index) {
+  auto it = m_lists.find(key);
+  if (it == m_lists.end() || index >= it->second.elements.size())
+    return false;
+  it->second.array.remove_child(it->second.elements[index]);
+  it->second.elements.erase(it->second.elements.begin() + index);
+  return true;
+}
+
+} // namespace sjef::util
@@ -0,0 +1,133 @@
+#ifndef SJEF_LIB_UTIL_PROPERTYSTORE_H_
+#define SJEF_LIB_UTIL_PROPERTYSTORE_H_
+#include <deque>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <pugixml.hpp>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace sjef::util {
+/*!
+ * @brief An in-memory key/value table backed by a property list document.
+ *
+ * The document has the form <tt>\<plist\>\<dict\>\<key\>k\</key\>\<string\>v\</string\>...\</dict\>\</plist\></tt>.
+ * A value may instead be a list, <tt>\<array\>\<string\>v1\</string\>...\</array\></tt>.
+ * Every key is held in a hash index that points at its nodes in the document, so that lookup, assignment and removal
+ * cost O(1) regardless of how many properties there are, while the document itself is kept in step for persistence.
+ * Likewise the elements of each list are indexed, so that indexed access, appending, and removal at either end cost
+ * O(1) regardless of the length of the list. The keys of string values are also kept in order, so that all those sharing
+ * a prefix can be found in O(log n) plus the number found.
+ * Concurrent calls of const member functions are safe; otherwise callers are expected to serialise access.
+ */
+class PropertyStore {
+public:
+  PropertyStore();
+  ~PropertyStore();
+  PropertyStore(const PropertyStore& source);
+  PropertyStore& operator=(const PropertyStore&) = delete;
+
+  /*!
+   * @brief Replace the contents of the store with those of a property list file
+   * @param file
+   * @return An empty string on success, otherwise a description of the parse error
+   */
+  std::string load(const std::filesystem::path& file);
+  /*!
+   * @brief Write the contents of the store to a property list file
+   * @param file
+   * @return true on success
+   */
+  bool save(const std::filesystem::path& file) const;
+
+  /*!
+   * @brief Look up a key
+   * @param key
+   * @return The value, or nullptr if the key is not present. The pointer is invalidated by any change to the store.
+   */
+  const char* get(const std::string& key) const;
+  /*!
+   * @brief Assign a value to a key, adding the key if it is not already present
+   * @param key
+   * @param value
+   */
+  void set(const std::string& key, const std::string& value);
+  /*!
+   * @brief Remove a key
+   * @param key
+   * @return true if the key was present
+   */
+  bool erase(const std::string& key);
+  /*!
+   * @brief The keys, including those of lists, in document order
+   */
+  std::vector<std::string> names() const;
+  /*!
+   * @brief Look up all keys with string values that begin with a prefix
+   * @param prefix
+   * @return The keys and values
+   */
+  std::map<std::string, std::string> prefixed(const std::string& prefix) const;
+  size_t size() const { return m_index.size() + m_lists.size(); }
+
+  /*!
+   * @brief The number of elements of a list
+   * @param key
+   * @return The length of the list, or zero if there is no list with this key
+   */
+  size_t list_size(const std::string& key) const;
+  /*!
+   * @brief Look up an element of a list
+   * @param key
+   * @param index
+   * @return The value, or nullptr if there is no such element. The pointer is invalidated by any change to the store.
+   */
+  const char* list_get(const std::string& key, size_t index) const;
+  /*!
+   * @brief All the elements of a list, which is empty if there is no list with this key
+   */
+  std::vector<std::string> list(const std::string& key) const;
+  /*!
+   * @brief Make a key hold a list, replacing any existing value
+   * @param key
+   * @param values
+   */
+  void list_set(const std::string& key, const std::vector<std::string>& values);
+  /*!
+   * @brief Append an element to a list, creating the list if necessary, and replacing any existing non-list value
+   * @param key
+   * @param value
+   */
+  void list_append(const std::string& key, const std::string& value);
+  /*!
+   * @brief Remove an element of a list
+   * @param key
+   * @param index
+   * @return true if the element was present
+   */
+  bool list_erase(const std::string& key, size_t index);
+
+private:
+  struct entry {
+    pugi::xml_node key;
+    pugi::xml_node value;
+  };
+  std::unique_ptr<pugi::xml_document> m_document;
+  pugi::xml_node m_dict;
+  std::unordered_map<std::string, entry> m_index;
+  std::map<std::string_view, pugi::xml_node> m_sorted; ///< refers to the keys of m_index
+  struct list_entry {
+    pugi::xml_node key;
+    pugi::xml_node array;
+    std::deque<pugi::xml_node> elements;
+  };
+  std::unordered_map<std::string, list_entry> m_lists;
+  list_entry& new_list(const std::string& key);
+  void reindex();
+};
+
+} // namespace sjef::util
+#endif // SJEF_LIB_UTIL_PROPERTYSTORE_H_
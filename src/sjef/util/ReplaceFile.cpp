@@ -0,0 +1,29 @@
+#include "ReplaceFile.h"
+#if defined(WIN32) || defined(__WIN64)
+#include <chrono>
+#include <system_error>
+#include <thread>
+#include <windows.h>
+#endif
+
+namespace sjef::util {
+
+void replace_file(const std::filesystem::path& from, const std::filesystem::path& to) {
+#if defined(WIN32) || defined(__WIN64)
+  using namespace std::literals::chrono_literals;
+  for (auto delay = 1ms;; delay *= 2) {
+    if (MoveFileExW(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH))
+      return;
+    const auto error = GetLastError();
+    if ((error != ERROR_SHARING_VIOLATION and error != ERROR_ACCESS_DENIED and error != ERROR_LOCK_VIOLATION) or
+        delay > 1s)
+      throw std::filesystem::filesystem_error("Cannot replace file", from, to,
+                                              std::error_code(static_cast<int>(error), std::system_category()));
+    std::this_thread::sleep_for(delay);
+  }
+#else
+  std::filesystem::rename(from, to);
+#endif
+}
+
+} // namespace sjef::util
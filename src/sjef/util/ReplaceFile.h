@@ -0,0 +1,18 @@
+#ifndef SJEF_LIB_UTIL_REPLACEFILE_H_
+#define SJEF_LIB_UTIL_REPLACEFILE_H_
+#include <filesystem>
+
+namespace sjef::util {
+/*!
+ * @brief Rename a file over another in one step, so that readers see either the old file or the new one.
+ *
+ * On Windows, the replacement fails while another process has the file open, for example to read it or to scan it for
+ * viruses, so it is retried for up to about two seconds.
+ * @param from
+ * @param to
+ * @throws std::filesystem::filesystem_error if the file cannot be replaced
+ */
+void replace_file(const std::filesystem::path& from, const std::filesystem::path& to);
+
+} // namespace sjef::util
+#endif // SJEF_LIB_UTIL_REPLACEFILE_H_
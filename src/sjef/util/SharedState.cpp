@@ -0,0 +1,126 @@
+#include "SharedState.h"
+#include <atomic>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <fstream>
+#include <stdexcept>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace sjef::util {
+
+///> @private
+struct SharedState::layout {
+  std::atomic<std::uint64_t> property_generation;
+  std::atomic<std::uint64_t> property_base_generation;
+  std::atomic<std::int64_t> job_status; // one more than the status, so that zero means not recorded
+  std::atomic<std::int64_t> job_number;
+  std::atomic<std::int64_t> last_poll_time; // nanoseconds since the epoch of std::chrono::system_clock
+  std::atomic<std::int64_t> last_sync_time;
+};
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free,
+              "SharedState needs lock-free atomics to be shared between processes");
+
+SharedState::SharedState(const std::filesystem::path& file) {
+  try {
+    std::filesystem::create_directories(file.parent_path());
+    { std::ofstream(file, std::ios_base::app | std::ios_base::binary); } // create without truncating
+    if (std::filesystem::file_size(file) < sizeof(layout))
+      std::filesystem::resize_file(file, sizeof(layout));
+    boost::interprocess::file_mapping mapping(file.string().c_str(), boost::interprocess::read_write);
+    m_region = std::make_unique<boost::interprocess::mapped_region>(mapping, boost::interprocess::read_write, 0,
+                                                                    sizeof(layout));
+  } catch (const std::exception& e) {
+    throw std::runtime_error("Cannot map shared state file " + file.string() + ": " + e.what());
+  }
+  m_layout = static_cast<layout*>(m_region->get_address());
+#ifndef _WIN32
+  m_fd = open(file.string().c_str(), O_RDWR | O_CLOEXEC);
+#endif
+}
+
+SharedState::~SharedState() {
+#ifndef _WIN32
+  if (m_fd >= 0)
+    close(m_fd);
+#endif
+}
+
+void SharedState::touch() const {
+#ifndef _WIN32
+  if (m_fd >= 0)
+    futimens(m_fd, nullptr);
+#endif
+}
+
+std::uint64_t SharedState::property_generation() const {
+  return m_layout->property_generation.load(std::memory_order_acquire);
+}
+
+std::uint64_t SharedState::property_base_generation() const {
+  return m_layout->property_base_generation.load(std::memory_order_acquire);
+}
+
+std::uint64_t SharedState::advance_property_generation(bool rewritten) {
+  auto generation = m_layout->property_generation.load(std::memory_order_relaxed) + 1;
+  if (rewritten)
+    m_layout->property_base_generation.store(generation, std::memory_order_release);
+  m_layout->property_generation.store(generation, std::memory_order_release);
+  return generation;
+}
+
+void SharedState::begin_property_rewrite() {
+  m_layout->property_base_generation.store(m_layout->property_generation.load(std::memory_order_relaxed) + 1,
+                                           std::memory_order_seq_cst);
+}
+
+std::optional<int> SharedState::job_status() const {
+  auto value = m_layout->job_status.load(std::memory_order_acquire);
+  return value == 0 ? std::nullopt : std::optional<int>{static_cast<int>(value - 1)};
+}
+
+bool SharedState::set_job_status(std::optional<int> status) {
+  const std::int64_t value = status ? *status + 1 : 0;
+  if (m_layout->job_status.exchange(value, std::memory_order_acq_rel) == value)
+    return false;
+  touch();
+  return true;
+}
+
+std::int64_t SharedState::job_number() const { return m_layout->job_number.load(std::memory_order_acquire); }
+
+void SharedState::set_job_number(std::int64_t job_number) {
+  m_layout->job_number.store(job_number, std::memory_order_release);
+}
+
+///> @private
+inline SharedState::time_point to_time_point(std::int64_t nanoseconds) {
+  return SharedState::time_point{
+      std::chrono::duration_cast<SharedState::time_point::duration>(std::chrono::nanoseconds{nanoseconds})};
+}
+
+///> @private
+inline std::int64_t from_time_point(SharedState::time_point time) {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+}
+
+SharedState::time_point SharedState::last_poll_time() const {
+  return to_time_point(m_layout->last_poll_time.load(std::memory_order_acquire));
+}
+
+void SharedState::set_last_poll_time(time_point time) {
+  m_layout->last_poll_time.store(from_time_point(time), std::memory_order_release);
+}
+
+SharedState::time_point SharedState::last_sync_time() const {
+  return to_time_point(m_layout->last_sync_time.load(std::memory_order_acquire));
+}
+
+void SharedState::set_last_sync_time(time_point time) {
+  m_layout->last_sync_time.store(from_time_point(time), std::memory_order_release);
+}
+
+} // namespace sjef::util
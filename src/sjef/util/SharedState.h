@@ -0,0 +1,94 @@
+#ifndef SJEF_LIB_UTIL_SHAREDSTATE_H_
+#define SJEF_LIB_UTIL_SHAREDSTATE_H_
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <optional>
+
+namespace boost::interprocess {
+class mapped_region; ///< @private
+}
+
+namespace sjef::util {
+/*!
+ * @brief A small fixed-layout record belonging to a project, shared between all threads and processes through a
+ * memory-mapped file.
+ *
+ * The file is created zero-filled if it does not already exist, and a zero-filled record is a valid initial state, so
+ * that processes opening the same project concurrently need no further coordination. Fields are accessed atomically;
+ * the record must live on a file system that supports shared memory mappings.
+ */
+class SharedState {
+public:
+  explicit SharedState(const std::filesystem::path& file);
+  ~SharedState();
+  SharedState(const SharedState&) = delete;
+  SharedState& operator=(const SharedState&) = delete;
+
+  /*!
+   * @brief The generation of the project property file, which is advanced by every process each time it saves the file
+   */
+  std::uint64_t property_generation() const;
+  /*!
+   * @brief The property generation at which the property file was last rewritten in full, rather than by appending to
+   * its journal
+   */
+  std::uint64_t property_base_generation() const;
+  /*!
+   * @brief Record that the project properties have been saved. The caller must hold the project lock.
+   * @param rewritten Whether the property file has been rewritten in full and its journal emptied
+   * @return The new generation
+   */
+  std::uint64_t advance_property_generation(bool rewritten = true);
+  /*!
+   * @brief Record that the property file is about to be rewritten in full. Until advance_property_generation() is
+   * called, the base generation is ahead of the generation, which tells readers that do not hold the project lock that
+   * the file and journal may not match. The caller must hold the project lock.
+   */
+  void begin_property_rewrite();
+
+  /*!
+   * @brief Update the file's timestamp, to wake processes watching it. Changes made through the memory mapping are not
+   * otherwise visible to file watchers.
+   */
+  void touch() const;
+
+  using time_point = std::chrono::system_clock::time_point;
+  /*!
+   * @brief The status of the project's job, as last committed to the property file, or nothing if it has not been
+   * recorded here
+   */
+  std::optional<int> job_status() const;
+  /*!
+   * @brief Record the status of the project's job. If it has changed, the file's timestamp is updated, so that
+   * processes watching the file (see FileWatch) are woken.
+   * @param status
+   * @return Whether the status has changed
+   */
+  bool set_job_status(std::optional<int> status);
+  /*!
+   * @brief The number of the project's job, or zero if there is none
+   */
+  std::int64_t job_number() const;
+  void set_job_number(std::int64_t job_number);
+  /*!
+   * @brief When the job status was last obtained from the backend, or the epoch if never
+   */
+  time_point last_poll_time() const;
+  void set_last_poll_time(time_point time);
+  /*!
+   * @brief When the run directory was last synchronised with the backend, or the epoch if never
+   */
+  time_point last_sync_time() const;
+  void set_last_sync_time(time_point time);
+
+private:
+  struct layout;
+  std::unique_ptr<boost::interprocess::mapped_region> m_region;
+  layout* m_layout;
+  int m_fd = -1;
+};
+
+} // namespace sjef::util
+#endif // SJEF_LIB_UTIL_SHAREDSTATE_H_
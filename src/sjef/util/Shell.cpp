@@ -12,10 +12,14 @@
 #endif
 #include <chrono>
 #include <filesystem>
+#include <fstream>
 #include <regex>
 #include <sstream>
 #include <thread>
 #include <vector>
+#ifdef __linux__
+#include <sched.h>
+#endif
 
 namespace fs = std::filesystem;
 
@@ -245,6 +249,31 @@ void Shell::capture_job_number_from_error(const std::string& command) const {
   // std::cout << "capture_job_number returning, m_job_number="<<m_job_number<<std::endl;
 }
 
+#ifdef __linux__
+///> @private
+// Binds the calling thread to a set of cores while it exists, so that the processes it starts inherit the binding
+struct scoped_affinity {
+  explicit scoped_affinity(const std::vector<int>& cpus) {
+    if (cpus.empty() or ::sched_getaffinity(0, sizeof(m_saved), &m_saved) != 0)
+      return;
+    cpu_set_t affinity;
+    CPU_ZERO(&affinity);
+    for (const auto& cpu : cpus)
+      if (cpu >= 0 and cpu < CPU_SETSIZE)
+        CPU_SET(cpu, &affinity);
+    m_bound = ::sched_setaffinity(0, sizeof(affinity), &affinity) == 0;
+  }
+  ~scoped_affinity() {
+    if (m_bound)
+      ::sched_setaffinity(0, sizeof(m_saved), &m_saved);
+  }
+  scoped_affinity(const scoped_affinity&) = delete;
+  scoped_affinity& operator=(const scoped_affinity&) = delete;
+  cpu_set_t m_saved;
+  bool m_bound = false;
+};
+#endif
+
 void Shell::run_local_async(const std::string& command, const std::string& directory, int verbosity,
                             const std::string& out) const {
   fs::path current_path_save;
@@ -273,7 +302,12 @@ void Shell::run_local_async(const std::string& command, const std::string& direc
     shell_path = m_shell; // preserve prior behaviour if resolution fails
   m_trace(2 - verbosity) << "launching shell local process: " << executable("nohup") << " " << shell_path << " -c '"
                          << pipeline << "'" << std::endl;
-  m_process = bp::child(executable("nohup"), shell_path, "-c", pipeline, bp::std_out > out, bp::std_err > *m_err SJEF_NO_CONSOLE_WINDOW);
+  {
+#ifdef __linux__
+    scoped_affinity affinity(m_cpus);
+#endif
+    m_process = bp::child(executable("nohup"), shell_path, "-c", pipeline, bp::std_out > out, bp::std_err > *m_err SJEF_NO_CONSOLE_WINDOW);
+  }
   m_process.detach();
   capture_job_number_from_error(command);
   fs::current_path(current_path_save);
@@ -413,6 +447,16 @@ bool Shell::running() const {
   // if (localhost() and m_process.running()) return true;
   if (localhost() and m_job_number == 0)
     return m_process.running();
+#ifdef __linux__
+  if (localhost()) { // read the state that ps would report, without spawning it
+    std::ifstream stat("/proc/" + std::to_string(m_job_number) + "/stat");
+    std::string line;
+    if (!std::getline(stat, line))
+      return false;
+    const auto command_end = line.rfind(')');
+    return command_end != std::string::npos and command_end + 2 < line.size() and line[command_end + 2] != 'Z';
+  }
+#endif
   bp::ipstream out;
   auto command = std::string{"ps -l -p "} + std::to_string(m_job_number) + "; echo $?";
   auto proc = bp::child(std::vector<std::string>{"/bin/sh", "-c", command}, bp::std_out > out);
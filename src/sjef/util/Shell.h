@@ -11,6 +11,7 @@
 #include <boost/process/v1/child.hpp>
 #include <boost/process/v1/io.hpp>
 #endif
+#include <vector>
 namespace bp = boost::process;
 
 namespace sjef::util {
@@ -54,6 +55,12 @@ public:
   const std::string& out() const { return m_last_out; }
   const std::string& err() const { return m_last_err; }
   int job_number() const { return m_job_number; }
+  /*!
+   * @brief Bind the processes started by later local asynchronous commands to a set of cores. This is done only on
+   * Linux.
+   * @param cpus If empty, the processes are not bound
+   */
+  void cpus(std::vector<int> cpus) { m_cpus = std::move(cpus); }
   void wait(int min_wait_milliseconds = 1, int max_wait_milliseconds = 1000) const;
   bool running() const;
   /*!
@@ -87,6 +94,7 @@ private:
   mutable std::mutex m_run_mutex;
   mutable int m_job_number = 0;
   mutable bp::child m_process;
+  std::vector<int> m_cpus;
 
 protected:
   void run_local_sync(const std::string& command, const std::string& directory, int verbosity, const std::string& out,
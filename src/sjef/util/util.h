@@ -1,10 +1,26 @@
 #ifndef SJEF_LIB_UTIL_UTIL_H_
 #define SJEF_LIB_UTIL_UTIL_H_
+#include "../sjef.h"
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
 #include <ostream>
 #include <regex>
+#include <set>
+#include <string>
+#include <vector>
 
 namespace sjef::util {
 
+/*!
+ * @brief The directory holding the configuration and records of sjef for this user, taken from the environment variable
+ * SJEF_CONFIG if it is set, and otherwise ~/.sjef
+ */
+inline std::filesystem::path sjef_config_directory() {
+  const char* directory = std::getenv("SJEF_CONFIG");
+  return expand_path(directory == nullptr ? "~/.sjef" : directory);
+}
+
 inline std::vector<std::string> splitString(const std::string& input, char c = ' ', char quote = '\'') {
   std::vector<std::string> result;
   const char* str0 = strdup(input.c_str());
@@ -26,7 +26,10 @@ std::string msg() {
 int main(int argc, char* argv[]) {
   std::string logfile(argc > 1 ? argv[1] : "");
   sjef::util::Locker locker(logfile + ".lock");
-  auto bolt = locker.bolt();
+  if (argc > 3 && std::string{argv[3]} == "shared")
+    locker.add_shared_bolt();
+  else
+    locker.add_bolt();
 
   if (argc > 1)
     std::ofstream(argv[1], std::ofstream::app) << msg() << std::endl;
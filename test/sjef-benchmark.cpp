@@ -0,0 +1,241 @@
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <pugixml.hpp>
+#include <random>
+#include <sjef/sjef.h>
+#include <sjef/util/Locker.h>
+#include <string>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+/*
+ * Micro-benchmarks for sjef. Not run as part of the test suite, and built only on POSIX systems when BUILD_BENCHMARK is
+ * set; invoke as
+ *   sjef-benchmark [mode ...]
+ * with no mode meaning all of them.
+ */
+
+namespace fs = std::filesystem;
+using clock_type = std::chrono::steady_clock;
+
+static fs::path scratch_directory() {
+  auto dir = fs::temp_directory_path() / ("sjef-benchmark-" + std::to_string(clock_type::now().time_since_epoch().count()));
+  fs::create_directories(dir);
+  setenv("SJEF_CONFIG", (dir / "config").string().c_str(), 1);
+  return dir;
+}
+
+template <typename F>
+static double microseconds_per_call(size_t calls, F f) {
+  auto start = clock_type::now();
+  for (size_t i = 0; i < calls; ++i)
+    f(i);
+  return std::chrono::duration<double, std::micro>(clock_type::now() - start).count() / calls;
+}
+
+/*
+ * Cost of a single property_get() as the number of keys in the project grows, compared with locating the same key by
+ * the XPath query that would be needed on the raw document
+ */
+static void properties(const fs::path& dir) {
+  std::cout << "property lookup cost (microseconds per lookup)\n"
+            << std::setw(10) << "keys" << std::setw(16) << "property_get" << std::setw(16) << "xpath" << std::endl;
+  std::mt19937 rng(1);
+  for (size_t nkeys : {10, 100, 1000, 10000}) {
+    sjef::Project project(dir / ("properties" + std::to_string(nkeys) + ".sjef"), true, "", {{"inp", "inp"}}, false);
+    sjef::mapstringstring_t data;
+    std::vector<std::string> keys;
+    for (size_t i = 0; i < nkeys; ++i) {
+      keys.push_back("Backend/benchmark/parameter" + std::to_string(i));
+      data[keys.back()] = std::to_string(i);
+    }
+    project.property_set(data);
+    std::uniform_int_distribution<size_t> pick(0, nkeys - 1);
+    const size_t calls = 2000;
+    std::vector<size_t> order(calls);
+    for (auto& o : order)
+      o = pick(rng);
+    auto indexed = microseconds_per_call(calls, [&](size_t i) {
+      if (project.property_get(keys[order[i]]).empty())
+        throw std::logic_error("missing key");
+    });
+    pugi::xml_document document;
+    document.load_file(project.propertyFile().string().c_str());
+    auto xpath = microseconds_per_call(calls, [&](size_t i) {
+      auto query = "/plist/dict/key[text()='" + keys[order[i]] + "']/following-sibling::string[1]";
+      if (!document.select_node(query.c_str()).node())
+        throw std::logic_error("missing key");
+    });
+    std::cout << std::setw(10) << nkeys << std::setw(16) << indexed << std::setw(16) << xpath << std::endl;
+  }
+}
+
+/*
+ * Throughput of status() called in a tight loop, as a GUI refreshing a project list would, with and without another
+ * process-local writer updating the project
+ */
+static void status(const fs::path& dir) {
+  sjef::Project project(dir / "status.sjef", true, "", {{"inp", "inp"}}, false);
+  const auto duration = std::chrono::seconds(2);
+  for (bool writer : {false, true}) {
+    std::atomic<bool> stop = false;
+    std::thread writer_thread;
+    if (writer)
+      writer_thread = std::thread([&]() {
+        sjef::Project other(dir / "status.sjef", true, "", {{"inp", "inp"}}, false);
+        for (int i = 0; !stop; ++i) {
+          other.property_set("counter", std::to_string(i));
+          std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+      });
+    size_t calls = 0;
+    auto start = clock_type::now();
+    while (clock_type::now() - start < duration) {
+      for (int i = 0; i < 100; ++i)
+        project.status();
+      calls += 100;
+    }
+    stop = true;
+    if (writer_thread.joinable())
+      writer_thread.join();
+    std::cout << "status() calls per second" << (writer ? " with a writer updating every 10ms: " : ": ")
+              << static_cast<size_t>(calls / std::chrono::duration<double>(clock_type::now() - start).count())
+              << std::endl;
+  }
+}
+
+/*
+ * Cost of a single property_set() as the number of keys in the project grows, rewriting the property file each time
+ * compared with appending to the property journal
+ */
+static void journal(const fs::path& dir) {
+  std::cout << "property update cost (microseconds per update)\n"
+            << std::setw(10) << "keys" << std::setw(16) << "rewrite" << std::setw(16) << "journal" << std::endl;
+  for (size_t nkeys : {10, 100, 1000, 10000}) {
+    sjef::Project project(dir / ("journal" + std::to_string(nkeys) + ".sjef"), true, "", {{"inp", "inp"}}, false);
+    sjef::mapstringstring_t data;
+    for (size_t i = 0; i < nkeys; ++i)
+      data["Backend/benchmark/parameter" + std::to_string(i)] = std::to_string(i);
+    project.property_set(data);
+    const size_t calls = 200;
+    project.set_property_journal(0);
+    auto rewrite = microseconds_per_call(calls, [&](size_t i) { project.property_set("_status", std::to_string(i)); });
+    project.set_property_journal(size_t{1} << 20);
+    auto journal = microseconds_per_call(calls, [&](size_t i) { project.property_set("_status", std::to_string(i)); });
+    std::cout << std::setw(10) << nkeys << std::setw(16) << rewrite << std::setw(16) << journal << std::endl;
+  }
+}
+
+/*
+ * Cost of appending to and removing from the front of a list-valued property, such as run_directories, as the list
+ * grows; the property journal is used, so that the cost of saving does not hide that of the list itself
+ */
+static void lists(const fs::path& dir) {
+  std::cout << "list property cost (microseconds per operation)\n"
+            << std::setw(10) << "elements" << std::setw(16) << "append" << std::setw(16) << "erase front" << std::endl;
+  for (size_t nelements : {10, 100, 1000, 10000}) {
+    sjef::Project project(dir / ("lists" + std::to_string(nelements) + ".sjef"), true, "", {{"inp", "inp"}}, false);
+    std::vector<std::string> elements;
+    for (size_t i = 0; i < nelements; ++i)
+      elements.push_back("lists_" + std::to_string(i));
+    project.property_list_set("run_directories", elements);
+    project.set_property_journal(size_t{1} << 20);
+    const size_t calls = 200;
+    auto append = microseconds_per_call(
+        calls, [&](size_t i) { project.property_list_append("run_directories", "extra_" + std::to_string(i)); });
+    auto erase = microseconds_per_call(calls, [&](size_t) { project.property_list_erase("run_directories", 0); });
+    std::cout << std::setw(10) << nelements << std::setw(16) << append << std::setw(16) << erase << std::endl;
+  }
+}
+
+/*
+ * Lock acquisitions per second when several threads in each of several processes repeatedly hold the same lock for a
+ * short read that waits on the file system, taking exclusive bolts compared with shared ones
+ */
+static void locker(const fs::path& dir) {
+  const auto lockfile = dir / "locker.lock";
+  const auto hold = std::chrono::microseconds(100);
+  std::cout << "lock acquisitions per second, each held for " << hold.count() << " microseconds\n"
+            << std::setw(10) << "processes" << std::setw(10) << "threads" << std::setw(16) << "exclusive"
+            << std::setw(16) << "shared" << std::endl;
+  auto acquisitions = [&](int threads, bool shared, clock_type::time_point end) {
+    sjef::util::Locker locker(lockfile);
+    std::atomic<size_t> count = 0;
+    std::vector<std::thread> pool;
+    for (int t = 0; t < threads; ++t)
+      pool.emplace_back([&]() {
+        size_t n = 0;
+        for (; clock_type::now() < end; ++n)
+          if (shared) {
+            auto bolt = locker.shared_bolt();
+            std::this_thread::sleep_for(hold);
+          } else {
+            auto bolt = locker.bolt();
+            std::this_thread::sleep_for(hold);
+          }
+        count += n;
+      });
+    for (auto& thread : pool)
+      thread.join();
+    return size_t{count};
+  };
+  const auto duration = std::chrono::milliseconds(500);
+  for (int processes : {1, 4})
+    for (int threads : {1, 4}) {
+      std::cout << std::setw(10) << processes << std::setw(10) << threads;
+      for (bool shared : {false, true}) {
+        const auto end = clock_type::now() + duration;
+        int pipes[2];
+        if (pipe(pipes) != 0)
+          throw std::runtime_error("cannot create pipe");
+        std::vector<pid_t> children;
+        for (int p = 1; p < processes; ++p)
+          if (auto pid = fork(); pid == 0) {
+            auto count = acquisitions(threads, shared, end);
+            if (write(pipes[1], &count, sizeof(count)) != sizeof(count))
+              _exit(1);
+            _exit(0);
+          } else
+            children.push_back(pid);
+        auto total = acquisitions(threads, shared, end);
+        for (auto pid : children) {
+          size_t count = 0;
+          if (read(pipes[0], &count, sizeof(count)) == sizeof(count))
+            total += count;
+          waitpid(pid, nullptr, 0);
+        }
+        close(pipes[0]);
+        close(pipes[1]);
+        std::cout << std::setw(16) << static_cast<size_t>(total / std::chrono::duration<double>(duration).count());
+      }
+      std::cout << std::endl;
+    }
+}
+
+int main(int argc, char* argv[]) {
+  const std::map<std::string, void (*)(const fs::path&)> modes{
+      {"journal", journal}, {"lists", lists}, {"locker", locker}, {"properties", properties}, {"status", status}};
+  std::vector<std::string> selected(argv + 1, argv + argc);
+  if (selected.empty())
+    for (const auto& mode : modes)
+      selected.push_back(mode.first);
+  auto dir = scratch_directory();
+  int result = 0;
+  for (const auto& mode : selected) {
+    if (modes.count(mode) == 0) {
+      std::cerr << "Unknown mode " << mode << std::endl;
+      result = 1;
+      continue;
+    }
+    modes.at(mode)(dir);
+  }
+  fs::remove_all(dir);
+  return result;
+}
@@ -5,10 +5,13 @@
 #include <boost/process/child.hpp>
 #endif
 #define BOOST_PROCESS_VERSION 1
+#include <algorithm>
+#include <atomic>
 #include <filesystem>
 #include <fstream>
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
+#include <numeric>
 #include <sstream>
 #include <thread>
 #include <sjef/util/Locker.h>
@@ -149,6 +152,168 @@ TEST(Locker, thread_common_mutex) {
   fs::remove(lockfile);
 }
 
+TEST(Locker, shared) {
+  std::string lockfile{"shared.lock"};
+  sjef::util::Locker locker(lockfile);
+  std::atomic<int> readers = 0;
+  std::atomic<int> most_readers = 0;
+  auto reader = [&]() {
+    auto bolt = locker.shared_bolt();
+    auto nested = locker.shared_bolt();
+    int now = ++readers;
+    for (int most = most_readers; now > most && !most_readers.compare_exchange_weak(most, now);)
+      ;
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    --readers;
+  };
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; ++i)
+    threads.emplace_back(reader);
+  for (auto& thread : threads)
+    thread.join();
+  EXPECT_GT(most_readers, 1);
+
+  int flag = 0;
+  std::thread writer;
+  {
+    auto bolt = locker.shared_bolt();
+    EXPECT_THROW(locker.add_bolt(), std::logic_error);
+    writer = std::thread([&]() {
+      auto bolt = locker.bolt();
+      flag = 1;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    EXPECT_EQ(flag, 0);
+  }
+  writer.join();
+  EXPECT_EQ(flag, 1);
+  {
+    auto bolt = locker.bolt();
+    auto nested = locker.shared_bolt(); // behaves as a further exclusive bolt
+  }
+  EXPECT_THROW(locker.remove_shared_bolt(), std::out_of_range);
+  fs::remove(lockfile);
+}
+
+TEST(Locker, Interprocess_shared) {
+  namespace bp = ::boost::process;
+  const std::string logfile = "Interprocess_shared.log";
+  auto lockfile = logfile + ".lock";
+  std::filesystem::remove(logfile);
+  sjef::util::Locker locker(lockfile);
+  auto logger = fs::current_path() / (std::string{"logger"} + std::string{EXECUTABLE_SUFFIX});
+  bp::child writer;
+  {
+    auto bolt = locker.shared_bolt();
+    bp::child reader(logger.string(), std::vector<std::string>{logfile, "0", "shared"});
+    EXPECT_TRUE(reader.wait_for(std::chrono::seconds(10)));
+    writer = bp::child(logger.string(), std::vector<std::string>{logfile, "0"});
+    EXPECT_FALSE(writer.wait_for(std::chrono::milliseconds(200)));
+  }
+  EXPECT_TRUE(writer.wait_for(std::chrono::seconds(10)));
+  std::filesystem::remove(logfile);
+  std::filesystem::remove(lockfile);
+}
+
+TEST(Locker, statistics) {
+  std::string lockfile{"statistics.lock"};
+  sjef::util::Locker locker(lockfile);
+  auto before = locker.statistics();
+  EXPECT_EQ(before.path, fs::absolute(lockfile));
+  {
+    auto bolt = locker.bolt();
+    auto nested = locker.bolt();
+    EXPECT_EQ(locker.statistics().owner, std::this_thread::get_id());
+    std::thread([&]() { // another Locker on the same file shares the statistics
+      sjef::util::Locker other(lockfile);
+      EXPECT_EQ(other.statistics().owner, locker.statistics().owner);
+    }).join();
+  }
+  std::thread waiter;
+  {
+    auto bolt = locker.shared_bolt();
+    EXPECT_EQ(locker.statistics().shared_holders, 1);
+    EXPECT_EQ(locker.statistics().owner, std::thread::id{});
+    waiter = std::thread([&]() { auto bolt = locker.bolt(); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  }
+  waiter.join();
+  auto after = locker.statistics();
+  EXPECT_EQ(after.acquisitions - before.acquisitions, 2);
+  EXPECT_EQ(after.shared_acquisitions - before.shared_acquisitions, 1);
+  EXPECT_EQ(after.shared_holders, 0);
+  EXPECT_GE(after.max_wait, std::chrono::milliseconds(10));
+  EXPECT_GE(after.total_wait, after.max_wait);
+  EXPECT_EQ(std::accumulate(after.hold_histogram.begin(), after.hold_histogram.end(), std::uint64_t{0}),
+            after.acquisitions);
+  EXPECT_EQ(std::accumulate(after.shared_hold_histogram.begin(), after.shared_hold_histogram.end(), std::uint64_t{0}),
+            after.shared_acquisitions);
+  auto all = sjef::util::Locker::all_statistics();
+  EXPECT_TRUE(std::any_of(all.begin(), all.end(), [&](const auto& s) { return s.path == after.path; }));
+  fs::remove(lockfile);
+}
+
+TEST(Locker, timed) {
+  std::string lockfile{"timed.lock"};
+  sjef::util::Locker locker(lockfile);
+  {
+    auto bolt = locker.try_bolt();
+    EXPECT_TRUE(bolt);
+    EXPECT_TRUE(locker.try_bolt()); // nested in our own bolt
+    std::thread([&]() {
+      EXPECT_FALSE(locker.try_bolt());
+      EXPECT_FALSE(locker.try_shared_bolt());
+      const auto start = std::chrono::steady_clock::now();
+      EXPECT_FALSE(locker.bolt_for(std::chrono::milliseconds(50)));
+      EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(50));
+    }).join();
+  }
+  {
+    auto bolt = locker.shared_bolt();
+    std::thread([&]() {
+      EXPECT_TRUE(locker.try_shared_bolt());
+      EXPECT_FALSE(locker.bolt_for(std::chrono::milliseconds(10)));
+    }).join();
+  }
+  std::thread waiter;
+  {
+    auto bolt = locker.bolt();
+    waiter = std::thread([&]() { EXPECT_TRUE(locker.shared_bolt_for(std::chrono::seconds(10))); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  }
+  waiter.join();
+  EXPECT_TRUE(locker.try_bolt());
+  fs::remove(lockfile);
+}
+
+TEST(Locker, open_file_limit) {
+  const auto saved_limit = sjef::util::Locker::open_file_limit();
+  const auto initially_open = sjef::util::Locker::open_files();
+  sjef::util::Locker::set_open_file_limit(initially_open + 2);
+  std::vector<std::unique_ptr<sjef::util::Locker>> lockers;
+  for (int i = 0; i < 5; ++i)
+    lockers.push_back(std::make_unique<sjef::util::Locker>("open_file_limit_" + std::to_string(i) + ".lock"));
+  EXPECT_EQ(sjef::util::Locker::open_files(), initially_open);
+  for (auto& locker : lockers)
+    auto bolt = locker->bolt();
+  EXPECT_EQ(sjef::util::Locker::open_files(), initially_open + 2);
+  { // lock files with bolts placed stay open regardless of the limit
+    auto bolt0 = lockers[0]->bolt();
+    auto bolt1 = lockers[1]->shared_bolt();
+    auto bolt2 = lockers[2]->bolt();
+    EXPECT_EQ(sjef::util::Locker::open_files(), initially_open + 3);
+    auto bolt3 = lockers[0]->bolt();
+  }
+  sjef::util::Locker::set_open_file_limit(initially_open);
+  EXPECT_EQ(sjef::util::Locker::open_files(), initially_open);
+  for (auto& locker : lockers) {
+    const auto path = locker->path();
+    locker.reset();
+    fs::remove(path);
+  }
+  sjef::util::Locker::set_open_file_limit(saved_limit);
+}
+
 // TODO test interprocess locking
 TEST(Locker, Interprocess) {
   sjef::util::Locker l(".Interprocess.lock");
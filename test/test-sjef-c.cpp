@@ -88,6 +88,35 @@ TEST_F(test_sjef, C_quick_destroy) {
   sjef_project_close(projname);
 }
 
+TEST_F(test_sjef, C_lock_statistics) {
+  const char* projname = strdup(testproject("C_lock_statistics").string().c_str());
+  sjef_project_open(projname);
+  sjef_project_property_set(projname, "key", "value");
+  std::string lock;
+  char** paths = sjef_lock_paths();
+  ASSERT_NE(paths, nullptr);
+  for (char** path = paths; *path != nullptr; ++path) {
+    if (std::string{*path}.find("C_lock_statistics") != std::string::npos)
+      lock = *path;
+    free(*path);
+  }
+  free(paths);
+  ASSERT_FALSE(lock.empty());
+  std::map<std::string, std::string> statistics;
+  char** values = sjef_lock_statistics(lock.c_str());
+  ASSERT_NE(values, nullptr);
+  for (char** value = values; *value != nullptr; value += 2) {
+    statistics[value[0]] = value[1];
+    free(value[0]);
+    free(value[1]);
+  }
+  free(values);
+  EXPECT_GT(std::stoi(statistics["acquisitions"]), 0);
+  EXPECT_EQ(statistics["owner"], "");
+  EXPECT_EQ(sjef_lock_statistics("no-such-lock"), nullptr);
+  sjef_project_close(projname);
+}
+
 TEST_F(test_sjef, C_values) { // TODO actually implement some of this for C
   const char* projname = strdup(testproject("C_project").string().c_str());
   fs::remove_all(projname);
@@ -4,15 +4,19 @@
 #include "test-sjef.h"
 #include <filesystem>
 #include <fstream>
+#include <future>
 #include <list>
 #include <map>
 #include <regex>
+#include <set>
 #include <sjef/sjef-backend.h>
 #include <sjef/sjef.h>
 #include <sjef/util/Locker.h>
 #include <sjef/util/Shell.h>
 #include <stdlib.h>
 #include <sjef/util/Job.h>
+#include <sjef/util/HostCapabilities.h>
+#include <sjef/util/LocalSlots.h>
 #include <pugixml.hpp>
 #ifndef WIN32
 #include <unistd.h>
@@ -211,6 +215,370 @@ TEST_F(test_sjef, properties) {
   }
 }
 
+TEST_F(test_sjef, properties_many) {
+  auto filename = testproject("many_properties");
+  const int n = 500;
+  sjef::mapstringstring_t data;
+  {
+    sjef::Project x(filename);
+    for (int i = 0; i < n; ++i)
+      data["key" + std::to_string(i)] = "value" + std::to_string(i);
+    x.property_set(data);
+    x.property_set("key7", "changed");
+    data["key7"] = "changed";
+    for (int i = 0; i < n; i += 2) {
+      x.property_delete("key" + std::to_string(i));
+      data.erase("key" + std::to_string(i));
+    }
+    for (const auto& [key, value] : data)
+      ASSERT_EQ(x.property_get(key), value);
+    EXPECT_EQ(x.property_get("key0"), "");
+  }
+  sjef::Project y(filename);
+  for (const auto& [key, value] : data)
+    ASSERT_EQ(y.property_get(key), value);
+  auto names = y.property_names();
+  EXPECT_EQ(std::count_if(names.begin(), names.end(), [](const std::string& s) { return s.rfind("key", 0) == 0; }),
+            data.size());
+  EXPECT_EQ(std::set<std::string>(names.begin(), names.end()).size(), names.size());
+}
+
+TEST_F(test_sjef, property_transaction) {
+  auto filename = testproject("property_transaction");
+  sjef::Project x(filename);
+  x.set_property_journal(0);
+  auto file_contents = [&x]() {
+    std::ifstream s(x.propertyFile());
+    return std::string(std::istreambuf_iterator<char>(s), std::istreambuf_iterator<char>());
+  };
+  {
+    auto transaction = x.transaction();
+    x.property_set("first", "1");
+    {
+      auto inner = x.transaction();
+      x.property_set("second", "2");
+    }
+    x.property_delete("first");
+    x.property_set("third", "3");
+    EXPECT_EQ(x.property_get("second"), "2");
+    EXPECT_EQ(x.property_get("first"), "");
+    EXPECT_EQ(file_contents().find("second"), std::string::npos);
+  }
+  EXPECT_NE(file_contents().find("second"), std::string::npos);
+  EXPECT_NE(file_contents().find("third"), std::string::npos);
+  EXPECT_EQ(file_contents().find("first"), std::string::npos);
+  try {
+    auto transaction = x.transaction();
+    x.property_set("fourth", "4");
+    throw std::runtime_error("abandon transaction");
+  } catch (const std::runtime_error&) {
+  }
+  EXPECT_EQ(x.property_get("fourth"), "");
+  EXPECT_EQ(x.property_get("third"), "3");
+  EXPECT_EQ(sjef::Project(filename).property_get("third"), "3");
+  {
+    auto transaction = x.transaction();
+    x.property_set("fifth", "5");
+    transaction.commit();
+    EXPECT_NE(file_contents().find("fifth"), std::string::npos);
+  }
+  // a directory where the new property file would be written, so that saving fails
+  fs::create_directory(filename / ".Info.plist.new");
+  {
+    auto transaction = x.transaction();
+    x.property_set("sixth", "6");
+    EXPECT_THROW(transaction.commit(), std::exception);
+  }
+  fs::remove(filename / ".Info.plist.new");
+  EXPECT_EQ(x.property_get("sixth"), "");
+  EXPECT_EQ(x.property_get("fifth"), "5");
+}
+
+TEST_F(test_sjef, property_generation) {
+  auto filename = testproject("property_generation");
+  sjef::Project x(filename);
+  sjef::Project y(filename);
+  EXPECT_TRUE(fs::exists(x.filename() / ".Info.plist.state"));
+  for (int i = 0; i < 10; ++i) {
+    y.property_set("key", std::to_string(i));
+    ASSERT_EQ(x.property_get("key"), std::to_string(i));
+    x.property_set("other", std::to_string(i));
+    ASSERT_EQ(y.property_get("other"), std::to_string(i));
+  }
+}
+
+TEST_F(test_sjef, property_journal) {
+  auto filename = testproject("property_journal");
+  const auto journal = filename / ".Info.plist.journal";
+  {
+    sjef::Project x(filename);
+    sjef::Project y(filename);
+    x.set_property_journal(1000);
+    y.set_property_journal(0);
+    auto file_contents = [&x]() {
+      std::ifstream s(x.propertyFile());
+      return std::string(std::istreambuf_iterator<char>(s), std::istreambuf_iterator<char>());
+    };
+    const auto plist = file_contents();
+    x.property_set("key", "value");
+    x.property_set("other", "value");
+    x.property_delete("other");
+    EXPECT_EQ(file_contents(), plist);
+    EXPECT_GT(fs::file_size(journal), 0);
+    EXPECT_EQ(y.property_get("key"), "value");
+    EXPECT_EQ(y.property_get("other"), "");
+    y.property_set("key", "changed"); // y does not use the journal, so rewrites the file and empties the journal
+    EXPECT_EQ(fs::file_size(journal), 0);
+    EXPECT_EQ(x.property_get("key"), "changed");
+    for (int i = 0; i < 100; ++i) {
+      x.property_set("counter", std::to_string(i));
+      ASSERT_EQ(y.property_get("counter"), std::to_string(i));
+      ASSERT_LE(fs::file_size(journal), 1000);
+    }
+    EXPECT_GT(fs::file_size(journal), 0);
+  }
+  EXPECT_EQ(fs::file_size(journal), 0);
+  sjef::Project z(filename);
+  EXPECT_EQ(z.property_get("key"), "changed");
+  EXPECT_EQ(z.property_get("counter"), "99");
+}
+
+TEST_F(test_sjef, property_list_compaction_stress) {
+  auto filename = testproject("property_list_compaction_stress");
+  sjef::Project writer(filename);
+  sjef::Project reader(filename);
+  writer.set_property_journal(200); // compacted every few appends
+  const int n = 300;
+  std::atomic<bool> done = false;
+  std::thread reading([&]() {
+    while (!done) {
+      const auto list = reader.property_list_get("list");
+      // a journal replayed over a compacted file would repeat elements
+      for (size_t i = 0; i < list.size(); ++i)
+        ASSERT_EQ(list[i], std::to_string(i));
+    }
+  });
+  for (int i = 0; i < n; ++i)
+    writer.property_list_append("list", std::to_string(i));
+  done = true;
+  reading.join();
+  EXPECT_EQ(reader.property_list_size("list"), n);
+}
+
+TEST_F(test_sjef, property_list) {
+  auto filename = testproject("property_list");
+  sjef::Project x(filename);
+  sjef::Project y(filename);
+  x.set_property_journal(1000);
+  EXPECT_EQ(x.property_list_size("list"), 0);
+  for (int i = 0; i < 5; ++i)
+    x.property_list_append("list", std::to_string(i));
+  x.property_list_erase("list", 0);
+  x.property_list_erase("list", 2);
+  const std::vector<std::string> expected{"1", "2", "4"};
+  EXPECT_EQ(x.property_list_get("list"), expected);
+  EXPECT_EQ(y.property_list_get("list"), expected);
+  EXPECT_EQ(y.property_list_size("list"), 3);
+  EXPECT_EQ(y.property_list_get("list", 2), "4");
+  EXPECT_EQ(y.property_list_get("list", 3), "");
+  EXPECT_EQ(y.property_get("list"), "");
+  y.property_list_set("list", {"a", "b"});
+  EXPECT_EQ(x.property_list_get("list"), (std::vector<std::string>{"a", "b"}));
+  x.property_set("list", "scalar");
+  EXPECT_EQ(y.property_list_size("list"), 0);
+  EXPECT_EQ(y.property_get("list"), "scalar");
+  y.property_list_append("list", "c");
+  EXPECT_EQ(x.property_list_get("list"), std::vector<std::string>{"c"});
+  EXPECT_EQ(x.property_get("list"), "");
+  sjef::Project z(filename);
+  EXPECT_EQ(z.property_list_get("list"), std::vector<std::string>{"c"});
+}
+
+TEST_F(test_sjef, property_list_legacy) {
+  auto filename = testproject("property_list_legacy");
+  for (const auto& run : {"property_list_legacy_1", "property_list_legacy_2"})
+    fs::create_directories(filename / "run" / (std::string{run} + "." + suffix()));
+  const std::string legacy = "<?xml version=\"1.0\"?>\n<plist><dict>"
+                             "<key>run_directories</key><string>property_list_legacy_2 property_list_legacy_1 </string>"
+                             "<key>IMPORTED</key><string>2</string>"
+                             "<key>IMPORT0</key><string>a.xyz</string>"
+                             "<key>IMPORT1</key><string>b.xyz</string>"
+                             "</dict></plist>";
+  std::ofstream(filename / "Info.plist") << legacy;
+  // read and write the file as earlier versions do
+  auto legacy_node = [&](pugi::xml_document& doc, const std::string& key) {
+    doc.load_file((filename / "Info.plist").c_str());
+    return doc.select_node(("/plist/dict/key[text()='" + key + "']/following-sibling::string[1]").c_str()).node();
+  };
+  auto legacy_get = [&](const std::string& key) {
+    pugi::xml_document doc;
+    return std::string{legacy_node(doc, key).child_value()};
+  };
+  sjef::Project x(filename);
+  EXPECT_EQ(x.run_list(), (std::vector<std::string>{"property_list_legacy_2", "property_list_legacy_1"}));
+  EXPECT_EQ(x.property_list_get("imports"), (std::vector<std::string>{"a.xyz", "b.xyz"}));
+  // opening the project does not rewrite it in a form that earlier versions cannot read
+  std::ifstream s(filename / "Info.plist");
+  EXPECT_EQ(std::string(std::istreambuf_iterator<char>(s), std::istreambuf_iterator<char>()), legacy);
+  // and an earlier version sees the changes
+  x.run_delete(1);
+  EXPECT_EQ(x.run_list(), std::vector<std::string>{"property_list_legacy_1"});
+  EXPECT_EQ(legacy_get("run_directories"), "property_list_legacy_1 ");
+  EXPECT_EQ(legacy_get("IMPORTED"), "2");
+  EXPECT_EQ(legacy_get("IMPORT0"), "a.xyz");
+  EXPECT_EQ(legacy_get("IMPORT1"), "b.xyz");
+  // while a change made by an earlier version is seen here
+  {
+    pugi::xml_document doc;
+    legacy_node(doc, "run_directories").text().set("property_list_legacy_2 property_list_legacy_1 ");
+    doc.save_file((filename / "Info.plist").c_str());
+  }
+  sjef::Project y(filename);
+  EXPECT_EQ(y.run_list(), (std::vector<std::string>{"property_list_legacy_2", "property_list_legacy_1"}));
+}
+
+TEST_F(test_sjef, property_get_prefix) {
+  sjef::Project x(testproject("property_get_prefix"));
+  x.property_set({{"Backend/x/a", "1"}, {"Backend/x/b", "2!documentation"}, {"Backend/y/c", "3"}, {"Backend/x", "4"}});
+  EXPECT_EQ(x.property_get_prefix("Backend/x/"),
+            (sjef::mapstringstring_t{{"Backend/x/a", "1"}, {"Backend/x/b", "2!documentation"}}));
+  EXPECT_EQ(x.property_get_prefix("Backend/z/"), sjef::mapstringstring_t{});
+  EXPECT_EQ(x.backend_parameter_values("x"), (sjef::mapstringstring_t{{"a", "1"}, {"b", "2"}}));
+  x.property_delete("Backend/x/a");
+  EXPECT_EQ(x.backend_parameter_values("x"), (sjef::mapstringstring_t{{"b", "2"}}));
+}
+
+TEST_F(test_sjef, property_file_changed_outside) {
+  auto filename = testproject("property_file_changed_outside");
+  sjef::Project x(filename);
+  x.property_set("key", "1");
+  EXPECT_EQ(x.property_get("key"), "1");
+  // as an earlier version of sjef, an editor or git would, without touching the shared state
+  std::ofstream(filename / "Info.plist") << "<?xml version=\"1.0\"?>\n<plist><dict>"
+                                         << "<key>key</key><string>22</string>"
+                                         << "</dict></plist>";
+  EXPECT_EQ(x.property_get("key"), "22");
+  x.property_set("other", "3");
+  sjef::Project y(filename);
+  EXPECT_EQ(y.property_get("key"), "22");
+  EXPECT_EQ(y.property_get("other"), "3");
+}
+
+TEST_F(test_sjef, property_subscribe) {
+  auto filename = testproject("property_subscribe");
+  sjef::Project x(filename);
+  sjef::Project y(filename);
+  std::mutex mutex;
+  std::condition_variable notified;
+  std::vector<sjef::mapstringstring_t> changes;
+  auto subscription = x.subscribe({"key", "other"}, [&](const sjef::mapstringstring_t& changed) {
+    std::lock_guard lock(mutex);
+    changes.push_back(changed);
+    notified.notify_all();
+  });
+  auto expect_changes = [&](size_t count) {
+    std::unique_lock lock(mutex);
+    return notified.wait_for(lock, std::chrono::seconds(5), [&]() { return changes.size() >= count; });
+  };
+  y.property_set("key", "1");
+  ASSERT_TRUE(expect_changes(1));
+  EXPECT_EQ(changes.back(), (sjef::mapstringstring_t{{"key", "1"}}));
+  y.property_set("unwatched", "1");
+  x.property_set("other", "2");
+  ASSERT_TRUE(expect_changes(2));
+  EXPECT_EQ(changes.back(), (sjef::mapstringstring_t{{"other", "2"}}));
+  y.property_delete("key");
+  ASSERT_TRUE(expect_changes(3));
+  EXPECT_EQ(changes.back(), (sjef::mapstringstring_t{{"key", ""}}));
+  x.unsubscribe(subscription);
+  y.property_set("key", "3");
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  std::lock_guard lock(mutex);
+  EXPECT_EQ(changes.size(), 3);
+}
+
+TEST_F(test_sjef, property_snapshot_read_while_locked) {
+  auto filename = testproject("property_snapshot");
+  sjef::Project x(filename);
+  x.property_set("key", "old");
+  std::promise<void> opened;
+  std::promise<void> release;
+  std::thread writer([&]() {
+    auto transaction = x.transaction();
+    x.property_set("key", "new");
+    opened.set_value();
+    release.get_future().wait();
+  });
+  opened.get_future().wait();
+  // the transaction is held until the reads have finished, so they finish only if they do not wait for it
+  auto reads = std::async(std::launch::async, [&x]() { return std::make_pair(x.property_get("key"), x.status()); });
+  const bool read_while_locked = reads.wait_for(std::chrono::seconds(10)) == std::future_status::ready;
+  release.set_value();
+  writer.join();
+  EXPECT_TRUE(read_while_locked);
+  EXPECT_EQ(reads.get(), std::make_pair(std::string{"old"}, sjef::unevaluated));
+  EXPECT_EQ(x.property_get("key"), "new");
+}
+
+TEST_F(test_sjef, copy_while_properties_locked) {
+  auto filename = testproject("copy_while_properties_locked");
+  auto copyname = testproject("copy_while_properties_locked_copy");
+  sjef::Project x(filename);
+  x.property_set("key", "old");
+  std::promise<void> opened;
+  std::promise<void> release;
+  std::thread writer([&]() {
+    auto transaction = x.transaction();
+    x.property_set("key", "new");
+    opened.set_value();
+    release.get_future().wait();
+  });
+  opened.get_future().wait();
+  // the transaction is held until the copy has finished, so it finishes only if it does not wait for it
+  auto copied = std::async(std::launch::async, [&]() { return x.copy(copyname) && x.run_list().empty(); });
+  const bool copied_while_locked = copied.wait_for(std::chrono::seconds(10)) == std::future_status::ready;
+  release.set_value();
+  writer.join();
+  EXPECT_TRUE(copied_while_locked);
+  EXPECT_TRUE(copied.get());
+  EXPECT_EQ(sjef::Project(copyname).property_get("key"), "old");
+  for (const auto& lock_file : {".lock", ".run.lock", ".sync.lock"})
+    EXPECT_TRUE(fs::exists(filename / lock_file)) << lock_file;
+}
+
+TEST_F(test_sjef, property_get_patience) {
+  auto filename = testproject("property_get_patience");
+  sjef::Project x(filename);
+  x.property_set("key", "old");
+  EXPECT_EQ(x.property_get("key", std::chrono::milliseconds(0)), "old");
+  EXPECT_EQ(x.status(std::chrono::milliseconds(0)), x.status());
+  EXPECT_EQ(x.status_message(0, std::chrono::milliseconds(0)), x.status_message());
+  // other duration types convert to the public overloads without ambiguity
+  EXPECT_EQ(x.status(std::chrono::seconds(1)), x.status());
+  EXPECT_EQ(x.status_message(0, std::chrono::seconds(1)), x.status_message());
+  EXPECT_EQ(x.property_get("key", std::chrono::seconds(1)), "old");
+  std::promise<void> opened;
+  std::promise<void> release;
+  std::thread writer([&]() {
+    auto transaction = x.transaction();
+    x.property_set("key", "new");
+    opened.set_value();
+    release.get_future().wait();
+  });
+  opened.get_future().wait();
+  // the transaction is held until the reads have finished, so they finish only if their patience runs out
+  auto reads = std::async(std::launch::async, [&x]() {
+    return std::make_pair(x.property_get(std::vector<std::string>{"key"}, std::chrono::milliseconds(10))["key"],
+                          x.status_message(0, std::chrono::milliseconds(10)));
+  });
+  const bool read_while_locked = reads.wait_for(std::chrono::seconds(10)) == std::future_status::ready;
+  release.set_value();
+  writer.join();
+  EXPECT_TRUE(read_while_locked);
+  EXPECT_EQ(reads.get(), std::make_pair(std::string{"old"}, std::string{"Unevaluated"}));
+  EXPECT_EQ(x.property_get("key", std::chrono::milliseconds(10)), "new");
+}
+
 TEST_F(test_sjef, recent_files) {
   {
     auto suffix = this->suffix();
@@ -619,6 +987,42 @@ TEST_F(test_sjef, run_directory) {
   //  system((std::string("ls -lR ")+p.filename()).c_str());
 }
 
+TEST_F(test_sjef, run_directory_properties) {
+  auto filename = testproject("run_directory_properties");
+  sjef::Project p(filename);
+  std::ofstream(p.filename("inp")) << "some input\n";
+  p.run_directory_new();
+  p.set_current_run(1);
+  p.property_set("run_input_hash", "1");
+  auto rundir = p.run_directory_new({{"run_input_hash", "2"}});
+  EXPECT_EQ(p.property_get("run_input_hash"), "2");
+  EXPECT_EQ(p.current_run(), 0);
+  // read directly, since opening the run directory as a Project forgets its run_input_hash
+  std::ifstream s(rundir / "Info.plist");
+  const auto plist = std::string(std::istreambuf_iterator<char>(s), std::istreambuf_iterator<char>());
+  EXPECT_TRUE(std::regex_search(plist, std::regex{"<key>run_input_hash</key>\\s*<string>2</string>"})) << plist;
+  EXPECT_TRUE(std::regex_search(plist, std::regex{"<key>current_run</key>\\s*<string>0</string>"})) << plist;
+}
+
+TEST_F(test_sjef, run_directory_removed_by_hand) {
+  auto filename = testproject("run_directory_removed_by_hand");
+  auto filename_copy = testfile("run_directory_removed_by_hand_copy." + suffix());
+  sjef::Project::erase(filename_copy);
+  sjef::Project p(filename);
+  std::ofstream(p.filename("inp")) << "some input\n";
+  for (int i = 0; i < 3; i++)
+    p.run_directory_new();
+  fs::remove_all(p.run_directory(1));
+  EXPECT_EQ(p.run_directory(1).filename().string(), p.run_directory_basename(2) + "." + suffix());
+  EXPECT_EQ(p.run_list().size(), 2);
+  EXPECT_TRUE(p.copy(filename_copy, false, false, false, 1));
+  EXPECT_EQ(sjef::Project(filename_copy).run_list().size(), 1);
+  fs::remove_all(p.run_directory(0));
+  EXPECT_NO_THROW(p.clean(0));
+  EXPECT_EQ(p.run_list().size(), 0);
+  EXPECT_EQ(p.run_directory(), p.filename());
+}
+
 #ifndef WIN32
 TEST_F(test_sjef, sync_backend) {
   auto suffix = this->suffix();
@@ -898,6 +1302,532 @@ TEST_F(test_sjef, kill) {
 #endif
 }
 
+TEST_F(test_sjef, job_state) {
+#ifndef WIN32
+  auto suffix = this->suffix();
+  const auto run_script = testfile("job_state.sh").string();
+  std::ofstream(sjef::expand_path((m_dot_sjef / suffix).string() + "/backends.xml"))
+      << "<?xml version=\"1.0\"?>\n<backends>\n <backend name=\"local\" run_command=\"true\"/>"
+      << "<backend name=\"test-local\" run_command=\"sh " << run_script << "\" />\n"
+      << "</backends>";
+  std::ofstream(run_script) << "sleep 2;";
+  auto p = sjef::Project(testfile(std::string{"job_state."} + suffix));
+  std::ofstream(p.filename("inp")) << "some input";
+  EXPECT_EQ(p.status(), sjef::unevaluated);
+  EXPECT_EQ(p.last_poll_time(), std::chrono::system_clock::time_point{});
+  p.run("test-local", 0, true, false);
+  for (int i = 0; i < 100 && p.status() != sjef::running; ++i)
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  ASSERT_EQ(p.status(), sjef::running);
+  const auto poll_time = p.last_poll_time();
+  const auto write_time = fs::last_write_time(p.propertyFile());
+  std::this_thread::sleep_for(std::chrono::milliseconds(500));
+  EXPECT_GT(p.last_poll_time(), poll_time);
+  EXPECT_EQ(fs::last_write_time(p.propertyFile()), write_time);
+  sjef::Project other(p.filename());
+  EXPECT_EQ(other.status(), sjef::running);
+  p.wait();
+  EXPECT_EQ(p.status(), sjef::completed);
+  EXPECT_EQ(other.status(), sjef::completed);
+  EXPECT_EQ(other.property_get("_status"), std::to_string(sjef::completed));
+#endif
+}
+
+TEST_F(test_sjef, concurrent_jobs_share_monitor) {
+#ifdef __linux__
+  auto suffix = this->suffix();
+  const auto run_script = testfile("concurrent_jobs.sh").string();
+  std::ofstream(sjef::expand_path((m_dot_sjef / suffix).string() + "/backends.xml"))
+      << "<?xml version=\"1.0\"?>\n<backends>\n <backend name=\"local\" run_command=\"true\"/>"
+      << "<backend name=\"test-local\" run_command=\"sh " << run_script << "\" />\n"
+      << "</backends>";
+  std::ofstream(run_script) << "sleep 2;";
+  auto threads = []() {
+    return std::distance(fs::directory_iterator("/proc/self/task"), fs::directory_iterator{});
+  };
+  const int n = 12;
+  std::list<sjef::Project> projects;
+  for (int i = 0; i < n; ++i) {
+    projects.emplace_back(testfile("concurrent_jobs_" + std::to_string(i) + "." + suffix));
+    std::ofstream(projects.back().filename("inp")) << "some input";
+  }
+  projects.front().run("test-local", 0, true, false); // starts the monitor
+  const auto threads_before = threads();
+  for (auto p = std::next(projects.begin()); p != projects.end(); ++p)
+    p->run("test-local", 0, true, false);
+  EXPECT_LT(threads() - threads_before, n / 2);
+  for (auto& p : projects) {
+    p.wait();
+    EXPECT_EQ(p.status(), sjef::completed) << p.filename();
+  }
+#endif
+}
+
+TEST_F(test_sjef, concurrent_polling) {
+#ifndef WIN32
+  if (sjef::util::JobMonitor::instance().threads() < 2)
+    GTEST_SKIP() << "one worker cannot poll concurrently";
+  auto suffix = this->suffix();
+  const auto run_script = testfile("concurrent_polling.sh").string();
+  const auto status_script = testfile("concurrent_polling_status.sh").string();
+  std::ofstream(sjef::expand_path((m_dot_sjef / suffix).string() + "/backends.xml"))
+      << "<?xml version=\"1.0\"?>\n<backends>\n <backend name=\"local\" run_command=\"true\"/>"
+      << "<backend name=\"test-concurrent-polling\" run_command=\"sh " << run_script << "\" status_command=\"sh "
+      << status_script << "\" poll_interval_max=\"0\" />\n"
+      << "</backends>";
+  std::ofstream(run_script) << "sleep 30;";
+  std::ofstream(status_script) << "sleep 0.2; /bin/ps -o pid,state -p $1"; // each status query is slow
+  const int n = 8;
+  std::list<sjef::Project> projects;
+  for (int i = 0; i < n; ++i) {
+    projects.emplace_back(testfile("concurrent_polling_" + std::to_string(i) + "." + suffix));
+    std::ofstream(projects.back().filename("inp")) << "some input";
+    projects.back().run("test-concurrent-polling", 0, true, false);
+  }
+  auto statistics = []() {
+    const auto all = sjef::util::Job::poll_statistics();
+    const auto backend = all.find("test-concurrent-polling");
+    return backend == all.end() ? sjef::util::Job::PollStatistics{} : backend->second;
+  };
+  const auto before = statistics();
+  const auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < 600 && statistics().polls < before.polls + 2 * n; ++i)
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  const auto after = statistics();
+  const auto elapsed = std::chrono::steady_clock::now() - start;
+  for (auto& p : projects)
+    p.kill();
+  EXPECT_GE(after.polls, before.polls + 2 * n);
+  // Polling cycles that ran one at a time could take no longer in total than the time in which they were counted, apart
+  // from the part of the first that came before it, whereas concurrent cycles take several times as long
+  const auto busy = after.busy - before.busy;
+  EXPECT_GT(busy, 2 * elapsed) << "polling cycles took "
+                               << std::chrono::duration_cast<std::chrono::milliseconds>(busy).count() << "ms in "
+                               << std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count() << "ms";
+#endif
+}
+
+TEST_F(test_sjef, poll_backoff) {
+#ifndef WIN32
+  auto suffix = this->suffix();
+  const auto run_script = testfile("poll_backoff.sh").string();
+  std::ofstream(sjef::expand_path((m_dot_sjef / suffix).string() + "/backends.xml"))
+      << "<?xml version=\"1.0\"?>\n<backends>\n <backend name=\"local\" run_command=\"true\"/>"
+      << "<backend name=\"test-poll-backoff\" run_command=\"sh " << run_script
+      << "\" poll_interval_min=\"0.05\" poll_interval_max=\"0.4\" />\n"
+      << "</backends>";
+  std::ofstream(run_script) << "sleep 3;";
+  auto p = sjef::Project(testfile(std::string{"poll_backoff."} + suffix));
+  std::ofstream(p.filename("inp")) << "some input";
+  p.run("test-poll-backoff", 0, true, false);
+  p.wait();
+  EXPECT_EQ(p.status(), sjef::completed);
+  const auto statistics = sjef::util::Job::poll_statistics().at("test-poll-backoff");
+  using namespace std::literals::chrono_literals;
+  EXPECT_GE(statistics.changes, 2); // started running, then completed
+  EXPECT_GT(statistics.max_interval, 200ms);
+  EXPECT_LE(statistics.max_interval, 400ms);
+  // backing off means far fewer polls than polling at the shortest interval for 3 seconds
+  EXPECT_LT(statistics.polls, 30);
+  EXPECT_GT(statistics.busy, 0ms);
+#endif
+}
+
+TEST_F(test_sjef, poll_failure) {
+#ifndef WIN32
+  auto suffix = this->suffix();
+  const auto run_script = testfile("poll_failure.sh").string();
+  const auto status_script = testfile("poll_failure_status.sh").string();
+  const auto count = testfile("poll_failure.count").string();
+  const auto finished = testfile("poll_failure.finished").string();
+  std::ofstream(sjef::expand_path((m_dot_sjef / suffix).string() + "/backends.xml"))
+      << "<?xml version=\"1.0\"?>\n<backends>\n <backend name=\"local\" run_command=\"true\"/>"
+      << "<backend name=\"test-poll-failure\" run_command=\"sh " << run_script << "\" status_command=\"sh "
+      << status_script << "\" poll_interval_max=\"0.1\" />\n"
+      << "</backends>";
+  std::ofstream(run_script) << "sleep 3; touch '" << finished << "'";
+  // the fourth status query fails, once the job has been seen running
+  std::ofstream(status_script) << "n=$(cat '" << count << "' 2>/dev/null || echo 0); echo $((n+1)) > '" << count
+                               << "'; [ $n -eq 3 ] && exit 1; /bin/ps -o pid,state -p $1";
+  auto p = sjef::Project(testfile(std::string{"poll_failure."} + suffix));
+  std::ofstream(p.filename("inp")) << "some input";
+  p.run("test-poll-failure", 0, true, false);
+  p.wait();
+  EXPECT_EQ(p.status(), sjef::completed);
+  // the failure is neither taken for the end of the job, nor stops polling
+  EXPECT_TRUE(fs::exists(finished));
+  std::ifstream counted(count);
+  int queries = 0;
+  counted >> queries;
+  EXPECT_GT(queries, 4);
+#endif
+}
+
+TEST_F(test_sjef, local_tracking_without_spawning) {
+#ifdef __linux__
+  auto suffix = this->suffix();
+  const auto run_script = testfile("local_tracking.sh").string();
+  std::ofstream(sjef::expand_path((m_dot_sjef / suffix).string() + "/backends.xml"))
+      << "<?xml version=\"1.0\"?>\n<backends>\n <backend name=\"local\" run_command=\"true\"/>"
+      << "<backend name=\"test-local\" run_command=\"sh " << run_script
+      << "\" poll_interval_min=\"30\" poll_interval_max=\"60\" />\n"
+      << "</backends>";
+  std::ofstream(run_script) << "sleep 1.5;";
+  auto p = sjef::Project(testfile(std::string{"local_tracking."} + suffix));
+  std::ofstream(p.filename("inp")) << "some input";
+  auto children = []() {
+    size_t result = 0;
+    for (const auto& task : fs::directory_iterator("/proc/self/task")) {
+      std::ifstream list(task.path() / "children");
+      for (int pid; list >> pid;)
+        ++result;
+    }
+    return result;
+  };
+  const auto start = std::chrono::steady_clock::now();
+  p.run("test-local", 0, true, false);
+  ASSERT_EQ(p.status(), sjef::running);
+  const auto polls = sjef::util::Job::poll_statistics().at("test-local").polls;
+  size_t spawned = 0;
+  while (p.status() == sjef::running) {
+    spawned = std::max(spawned, children());
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  EXPECT_EQ(spawned, 0);
+  EXPECT_GT(sjef::util::Job::poll_statistics().at("test-local").polls, polls);
+  p.wait();
+  EXPECT_EQ(p.status(), sjef::completed);
+  // the exit of the job wakes its polling task, since no poll falls due for 30 seconds after the first
+  EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(20));
+#endif
+}
+
+TEST_F(test_sjef, submission_latency) {
+#ifndef WIN32
+  auto suffix = this->suffix();
+  const auto run_script = testfile("submission_latency.sh").string();
+  std::ofstream(sjef::expand_path((m_dot_sjef / suffix).string() + "/backends.xml"))
+      << "<?xml version=\"1.0\"?>\n<backends>\n <backend name=\"local\" run_command=\"true\"/>"
+      << "<backend name=\"test-local\" run_command=\"sh " << run_script << "\" />\n"
+      << "</backends>";
+  const auto release = testfile("submission_latency.release");
+  std::ofstream(run_script) << "while [ ! -f '" << release.string() << "' ]; do sleep 0.05; done";
+  auto p = sjef::Project(testfile(std::string{"submission_latency."} + suffix));
+  std::ofstream(p.filename("inp")) << "some input";
+  const auto start = std::chrono::steady_clock::now();
+  p.run("test-local", 0, true, false);
+  // returns as soon as the job is confirmed, while it is still held, and long before the polling interval could grow
+  EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(10));
+  EXPECT_EQ(p.status(), sjef::running);
+  std::map<std::string, long> latencies;
+  std::istringstream stages(p.property_get("submission_latency"));
+  for (std::string stage; stages >> stage;)
+    latencies[stage.substr(0, stage.find('='))] = std::stol(stage.substr(stage.find('=') + 1));
+  EXPECT_THAT(latencies, ::testing::ElementsAre(::testing::Key("confirm"), ::testing::Key("jobnumber"),
+                                                ::testing::Key("push"), ::testing::Key("submit")));
+  EXPECT_LT(latencies["confirm"], 10'000'000);
+  std::ofstream{release};
+  p.wait();
+#endif
+}
+
+TEST_F(test_sjef, host_capabilities) {
+  auto& capabilities = sjef::util::HostCapabilities::instance();
+  EXPECT_FALSE(capabilities.get("somehost", "rsync"));
+  capabilities.set("somehost", "rsync", "/opt/bin/rsync");
+  EXPECT_EQ(capabilities.get("somehost", "rsync").value_or(""), "/opt/bin/rsync");
+  const auto now = std::chrono::duration_cast<std::chrono::seconds>(
+                       std::chrono::system_clock::now().time_since_epoch())
+                       .count();
+  // as recorded by other processes
+  std::ofstream(capabilities.file(), std::ios_base::app) << now << "\tsomehost\tdirectory /cache/1\tverified\n"
+                                                         << "0\tsomehost\trsync_version\t3.2.7\n";
+  EXPECT_TRUE(capabilities.get("somehost", "directory /cache/1"));
+  EXPECT_FALSE(capabilities.get("somehost", "rsync_version")) << "should have expired";
+  EXPECT_FALSE(capabilities.get("otherhost", "directory /cache/1"));
+  capabilities.forget("somehost", "directory /cache/1");
+  EXPECT_FALSE(capabilities.get("somehost", "directory /cache/1"));
+  EXPECT_TRUE(capabilities.get("somehost", "rsync"));
+  capabilities.forget("somehost");
+  EXPECT_FALSE(capabilities.get("somehost", "rsync"));
+}
+
+TEST_F(test_sjef, batch_status) {
+#ifndef WIN32
+  auto suffix = this->suffix();
+  const auto run_script = testfile("batch_status.sh").string();
+  const auto status_script = testfile("batch_status_query.sh").string();
+  const auto status_log = testfile("batch_status.log").string();
+  std::ofstream(sjef::expand_path((m_dot_sjef / suffix).string() + "/backends.xml"))
+      << "<?xml version=\"1.0\"?>\n<backends>\n <backend name=\"local\" run_command=\"true\"/>"
+      << "<backend name=\"test-local\" run_command=\"sh " << run_script << "\" status_batch_command=\"sh "
+      << status_script << " {jobs}\" />\n"
+      << "</backends>";
+  std::ofstream(run_script) << "sleep 3;";
+  std::ofstream(status_script) << "echo $1 >> " << status_log << "; /bin/ps -o pid,state -p $1";
+  const int n = 4;
+  std::list<sjef::Project> projects;
+  for (int i = 0; i < n; ++i) {
+    projects.emplace_back(testfile("batch_status_" + std::to_string(i) + "." + suffix));
+    std::ofstream(projects.back().filename("inp")) << "some input";
+    projects.back().run("test-local", 0, true, false);
+  }
+  for (auto& p : projects)
+    EXPECT_EQ(p.status(), sjef::running) << p.filename();
+  std::this_thread::sleep_for(std::chrono::milliseconds(500));
+  std::ifstream log(status_log);
+  size_t largest_batch = 0;
+  for (std::string line; std::getline(log, line);)
+    largest_batch = std::max(largest_batch, size_t(std::count(line.begin(), line.end(), ',') + 1));
+  EXPECT_EQ(largest_batch, n);
+  for (auto& p : projects) {
+    p.wait();
+    EXPECT_EQ(p.status(), sjef::completed) << p.filename();
+  }
+#endif
+}
+
+TEST_F(test_sjef, batch_status_frees_workers) {
+#ifndef WIN32
+  auto suffix = this->suffix();
+  const auto run_script = testfile("batch_status_slow.sh").string();
+  const auto status_script = testfile("batch_status_slow_query.sh").string();
+  std::ofstream(sjef::expand_path((m_dot_sjef / suffix).string() + "/backends.xml"))
+      << "<?xml version=\"1.0\"?>\n<backends>\n <backend name=\"local\" run_command=\"true\"/>"
+      << "<backend name=\"test-local\" run_command=\"sh " << run_script << "\" status_batch_command=\"sh "
+      << status_script << " {jobs}\" poll_interval_max=\"1\" />\n"
+      << "</backends>";
+  const auto hold = testfile("batch_status_slow.hold").string();
+  const auto holding = testfile("batch_status_slow.holding").string();
+  std::ofstream(run_script) << "sleep 4;";
+  // while the hold file exists, a query does not finish
+  std::ofstream(status_script) << "if [ -f '" << hold << "' ]; then touch '" << holding << "'; while [ -f '" << hold
+                               << "' ]; do sleep 0.05; done; fi; /bin/ps -o pid,state -p $1";
+  // more jobs than workers, so that if those waiting for the query held their workers, there would be none to spare
+  const auto n = sjef::util::JobMonitor::instance().threads() + 1;
+  std::list<sjef::Project> projects;
+  for (size_t i = 0; i < n; ++i) {
+    projects.emplace_back(testfile("batch_status_slow_" + std::to_string(i) + "." + suffix));
+    std::ofstream(projects.back().filename("inp")) << "some input";
+    projects.back().run("test-local", 0, true, false);
+  }
+  std::ofstream{hold};
+  for (int i = 0; i < 300 && !fs::exists(holding); ++i)
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  const bool held = fs::exists(holding);
+  if (!held)
+    fs::remove(hold);
+  ASSERT_TRUE(held);
+  // a query is now held for as long as the test chooses, so other tasks run only if the jobs waiting for it do not
+  // hold their workers
+  int called_during_query = 0;
+  for (int i = 0; i < 10; ++i) {
+    auto called = std::make_shared<std::promise<void>>();
+    sjef::util::JobMonitor::instance().add([called]() -> std::optional<sjef::util::JobMonitor::clock::duration> {
+      called->set_value();
+      return std::nullopt;
+    });
+    if (called->get_future().wait_for(std::chrono::seconds(10)) != std::future_status::ready)
+      break;
+    ++called_during_query;
+  }
+  fs::remove(hold);
+  EXPECT_EQ(called_during_query, 10);
+  for (auto& p : projects) {
+    p.wait();
+    EXPECT_EQ(p.status(), sjef::completed) << p.filename();
+  }
+#endif
+}
+
+TEST_F(test_sjef, submit_many) {
+#ifndef WIN32
+  auto suffix = this->suffix();
+  const auto array_script = testfile("submit_many.sh").string();
+  const auto array_log = testfile("submit_many.log").string();
+  std::ofstream(sjef::expand_path((m_dot_sjef / suffix).string() + "/backends.xml"))
+      << "<?xml version=\"1.0\"?>\n<backends>\n <backend name=\"local\" run_command=\"true\"/>"
+      << "<backend name=\"test-array\" run_command=\"false\" run_array_command=\"sh " << array_script
+      << "\" run_jobnumber=\"Submitted batch job ([0-9]+)\" />\n"
+      << "</backends>";
+  // a fake scheduler that starts each of its inputs, and reports a job number for each
+  std::ofstream(array_script) << "echo $# >> " << array_log
+                              << "; for input in \"$@\"; do (sleep 1; cp \"$input\" \"$input.done\") >/dev/null 2>&1 & "
+                                 "echo \"Submitted batch job $!\"; done";
+  const int n = 3;
+  std::list<sjef::Project> projects;
+  std::vector<sjef::Project*> pointers;
+  for (int i = 0; i < n; ++i) {
+    projects.emplace_back(testfile("submit_many_" + std::to_string(i) + "." + suffix));
+    std::ofstream(projects.back().filename("inp")) << "some input " << i;
+    pointers.push_back(&projects.back());
+  }
+  EXPECT_EQ(sjef::submit_many(pointers, "test-array"), std::vector<bool>(n, true));
+  std::ifstream log(array_log);
+  std::string submissions;
+  std::getline(log, submissions);
+  EXPECT_EQ(submissions, std::to_string(n)) << "all the jobs should be submitted with one command";
+  std::set<std::string> job_numbers;
+  for (auto& p : projects) {
+    EXPECT_NE(p.property_get("jobnumber"), "0") << p.filename();
+    job_numbers.insert(p.property_get("jobnumber"));
+    EXPECT_EQ(p.status(), sjef::running) << p.filename();
+  }
+  EXPECT_EQ(job_numbers.size(), n);
+  for (auto& p : projects) {
+    p.wait();
+    EXPECT_EQ(p.status(), sjef::completed) << p.filename();
+    EXPECT_TRUE(fs::exists(p.filename("inp", "", 0).string() + ".done")) << p.filename();
+  }
+#endif
+}
+
+TEST_F(test_sjef, submit_many_failure) {
+#ifndef WIN32
+  auto suffix = this->suffix();
+  const auto array_script = testfile("submit_many_failure.sh").string();
+  std::ofstream(sjef::expand_path((m_dot_sjef / suffix).string() + "/backends.xml"))
+      << "<?xml version=\"1.0\"?>\n<backends>\n <backend name=\"local\" run_command=\"true\"/>"
+      << "<backend name=\"test-array\" run_command=\"false\" run_array_command=\"sh " << array_script
+      << "\" run_jobnumber=\"Submitted batch job ([0-9]+)\" />\n"
+      << "</backends>";
+  // a fake scheduler that reports a job number for all but one of its inputs
+  std::ofstream(array_script) << "shift; for input in \"$@\"; do echo \"Submitted batch job 99999\"; done";
+  const int n = 3;
+  std::list<sjef::Project> projects;
+  std::vector<sjef::Project*> pointers;
+  for (int i = 0; i < n; ++i) {
+    projects.emplace_back(testfile("submit_many_failure_" + std::to_string(i) + "." + suffix));
+    std::ofstream(projects.back().filename("inp")) << "some input " << i;
+    pointers.push_back(&projects.back());
+  }
+  EXPECT_THROW(sjef::submit_many(pointers, "test-array"), std::runtime_error);
+  for (auto& p : projects) {
+    EXPECT_EQ(p.status(), sjef::failed) << p.filename();
+    EXPECT_TRUE(p.run("local", 0, true, true)) << "a failed submission should not prevent another";
+  }
+#endif
+}
+
+TEST_F(test_sjef, local_slots) {
+#ifndef WIN32
+  auto suffix = this->suffix();
+  const auto run_script = testfile("local_slots.sh").string();
+  std::ofstream(sjef::expand_path((m_dot_sjef / suffix).string() + "/backends.xml"))
+      << "<?xml version=\"1.0\"?>\n<backends>\n <backend name=\"local\" run_command=\"true\"/>"
+      << "<backend name=\"test-local\" run_command=\"sh " << run_script << "\" />\n"
+      << "</backends>";
+  std::ofstream(run_script) << "sleep 0.5;";
+  const long slots = 2;
+  setenv("SJEF_LOCAL_SLOTS", std::to_string(slots).c_str(), 1);
+  const int n = 5;
+  std::list<sjef::Project> projects;
+  for (int i = 0; i < n; ++i) {
+    projects.emplace_back(testfile("local_slots_" + std::to_string(i) + "." + suffix));
+    std::ofstream(projects.back().filename("inp")) << "some input " << i;
+    projects.back().run("test-local", 0, true, false);
+  }
+  auto count = [&projects](sjef::status status) {
+    return std::count_if(projects.begin(), projects.end(), [status](const auto& p) { return p.status() == status; });
+  };
+  EXPECT_EQ(count(sjef::running), slots);
+  EXPECT_EQ(count(sjef::waiting), n - slots);
+  EXPECT_EQ(projects.back().property_get("jobnumber"), "0");
+  long most_running = 0;
+  for (int i = 0; i < 1000 and count(sjef::completed) < n; ++i) {
+    most_running = std::max(most_running, long(count(sjef::running)));
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  EXPECT_EQ(most_running, slots);
+  for (auto& p : projects) {
+    p.wait();
+    EXPECT_EQ(p.status(), sjef::completed) << p.filename();
+    EXPECT_NE(p.property_get("jobnumber"), "0") << p.filename();
+  }
+#endif
+}
+
+TEST_F(test_sjef, local_slots_destructor) {
+#ifndef WIN32
+  auto suffix = this->suffix();
+  const auto run_script = testfile("local_slots_destructor.sh").string();
+  std::ofstream(sjef::expand_path((m_dot_sjef / suffix).string() + "/backends.xml"))
+      << "<?xml version=\"1.0\"?>\n<backends>\n <backend name=\"local\" run_command=\"true\"/>"
+      << "<backend name=\"test-local\" run_command=\"sh " << run_script << "\" />\n"
+      << "</backends>";
+  std::ofstream(run_script) << "sleep 5;";
+  setenv("SJEF_LOCAL_SLOTS", "1", 1);
+  setenv("SJEF_LOCAL_QUEUE_WAIT", "1", 1);
+  auto running = sjef::Project(testfile("local_slots_destructor_running." + suffix));
+  std::ofstream(running.filename("inp")) << "some input";
+  running.run("test-local", 0, true, false);
+  const auto queued_file = testfile("local_slots_destructor_queued." + suffix);
+  auto start = std::chrono::steady_clock::now();
+  {
+    auto queued = sjef::Project(queued_file);
+    std::ofstream(queued.filename("inp")) << "some other input";
+    queued.run("test-local", 0, true, false);
+    EXPECT_EQ(queued.status(), sjef::waiting);
+    start = std::chrono::steady_clock::now();
+  }
+  EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(3));
+  auto queued = sjef::Project(queued_file);
+  EXPECT_EQ(queued.status(), sjef::killed);
+  EXPECT_FALSE(sjef::util::LocalSlots::instance().contains(queued.filename("", "", 0).string()));
+  running.kill();
+  unsetenv("SJEF_LOCAL_QUEUE_WAIT");
+#endif
+}
+
+TEST_F(test_sjef, local_placement) {
+#ifdef __linux__
+  auto suffix = this->suffix();
+  const auto run_script = testfile("local_placement.sh").string();
+  std::ofstream(sjef::expand_path((m_dot_sjef / suffix).string() + "/backends.xml"))
+      << "<?xml version=\"1.0\"?>\n<backends>\n <backend name=\"local\" run_command=\"true\"/>"
+      << "<backend name=\"test-local\" run_command=\"sh " << run_script << " {-n %n:1!MPI size}\" />\n"
+      << "</backends>";
+  std::ofstream(run_script) << "grep Cpus_allowed_list /proc/$$/status > cpus_allowed";
+  setenv("SJEF_LOCAL_SLOTS", "1", 1); // so that there is a free core for the job
+  auto p = sjef::Project(testfile(std::string{"local_placement."} + suffix));
+  std::ofstream(p.filename("inp")) << "some input";
+  p.run("test-local", 0, true, true); // unbound by default
+  EXPECT_EQ(p.status(), sjef::completed);
+  EXPECT_EQ(p.property_get("placement"), "");
+  setenv("SJEF_LOCAL_PLACEMENT", "cores", 1);
+  p.run("test-local", 0, true, true);
+  unsetenv("SJEF_LOCAL_PLACEMENT");
+  EXPECT_EQ(p.status(), sjef::completed);
+  std::smatch match;
+  const auto placement = p.property_get("placement");
+  ASSERT_TRUE(std::regex_match(placement, match, std::regex{"cpus=([-,0-9]+) numa_node=(-?[0-9]+)"})) << placement;
+  std::ifstream allowed(p.filename("", "cpus_allowed", 0));
+  std::string line;
+  std::getline(allowed, line);
+  EXPECT_EQ(line, "Cpus_allowed_list:\t" + match[1].str());
+  EXPECT_EQ(sjef::util::LocalSlots::cpu_list(match[1].str()).size(), size_t(1));
+#endif
+}
+
+TEST_F(test_sjef, wait_wakes_on_change) {
+#ifndef WIN32
+  auto suffix = this->suffix();
+  const auto run_script = testfile("wait_wakes_on_change.sh").string();
+  std::ofstream(sjef::expand_path((m_dot_sjef / suffix).string() + "/backends.xml"))
+      << "<?xml version=\"1.0\"?>\n<backends>\n <backend name=\"local\" run_command=\"true\"/>"
+      << "<backend name=\"test-local\" run_command=\"sh " << run_script << "\" />\n"
+      << "</backends>";
+  std::ofstream(run_script) << "sleep 0.7;";
+  auto p = sjef::Project(testfile(std::string{"wait_wakes_on_change."} + suffix));
+  std::ofstream(p.filename("inp")) << "some input";
+  p.run("test-local", 0, true, false);
+  const auto start = std::chrono::steady_clock::now();
+  p.wait(60'000'000); // a long safeguard interval, so that only a notification can end the wait within it
+  EXPECT_EQ(p.status(), sjef::completed);
+  EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(20));
+#endif
+}
+
 TEST_F(test_sjef, bad_remote) {
 #ifndef WIN32
   auto suffix = this->suffix();
@@ -48,6 +48,7 @@ protected:
     m_dot_sjef = tmp / "test_sjef_config";
     fs::create_directories(sjef::expand_path(m_dot_sjef));
     setenv("SJEF_CONFIG", m_dot_sjef.string().c_str(), 1);
+    setenv("SJEF_LOCAL_SLOTS", "1000", 1); // so that tests of concurrent jobs do not depend on the number of cores
     m_suffixes.push_back(m_default_suffix);
     for (const auto& suffix : m_suffixes) {
       const auto path = sjef::expand_path(m_dot_sjef / suffix);